@@ -0,0 +1,50 @@
+/************************************************
+Written for FACTS Engineering
+Copyright (c) 2019 FACTS Engineering, LLC
+Licensed under the MIT license.
+************************************************/
+
+#include <ViewMarq.h>
+
+//This example program shows how to use the ViewMarq Arduino library's message builder
+//to split a ViewMarq display into a label window and a counter window using an Arduino
+//Microprocessor and an Arduino Ethernet shield.
+
+IPAddress address(192, 168, 0, 182); // update with the IP Address of your Modbus server
+
+byte mac[6] = { 0xDE, 0xAD, 0xBE, 0xEF, 0xFE, 0xEF }; //change if there are any devices on your network with this MAC address
+
+EthernetClient signClient;
+
+VMDisplay sign(0, signClient, address);  //initialize the VMDisplay with its ID, communications client, and IPAddress.
+//if the ID is 0, any ViewMarq will accept the code. Anything else needs to be assigned to that ViewMarq via its software.
+
+void setup() {
+  Ethernet.begin(mac);  //begin ethernet communications
+  Serial.begin(9600);   //begin serial communications
+
+  sign.beginMessage();                  //start a new message
+  sign.win(0, 0, 143, 31);              //left half of the display
+  sign.pos(0, 0);
+  sign.scroll(CENTER_JUSTIFIED);
+  sign.font(3);
+  sign.color(AMBER);
+  sign.text("Count:");
+  sign.win(144, 0, 287, 31);            //right half of the display
+  sign.pos(144, 0);
+  sign.color(GREEN);
+  sign.dec(1, 5, 0);                    //show decimal variable 1 with 5 digits
+  if(!sign.endMessage()) {              //finish the message, checking that it fit
+    Serial.println("Message too long!");
+  }
+  sign.printMessage();                  //print the command string that was built
+}
+
+long int number = 1;
+
+void loop() {
+  sign.sendMessage();                   //send the, now written, message to the display
+  sign.updateDecimal(1, number, false); //update the counter without changing the message
+  delay(1000);
+  number++;
+}
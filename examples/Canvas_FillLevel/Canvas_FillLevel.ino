@@ -0,0 +1,49 @@
+/************************************************
+Written for FACTS Engineering
+Copyright (c) 2019 FACTS Engineering, LLC
+Licensed under the MIT license.
+************************************************/
+
+#include <ViewMarq.h>
+
+//This example program shows how to use the ViewMarq Arduino library's canvas to draw
+//a tank icon and a fill level bar on a ViewMarq display using an Arduino Microprocessor
+//and an Arduino Ethernet shield.
+
+IPAddress address(192, 168, 0, 182); // update with the IP Address of your Modbus server
+
+byte mac[6] = { 0xDE, 0xAD, 0xBE, 0xEF, 0xFE, 0xEF }; //change if there are any devices on your network with this MAC address
+
+EthernetClient signClient;
+
+VMDisplay sign(0, signClient, address);  //initialize the VMDisplay with its ID, communications client, and IPAddress.
+//if the ID is 0, any ViewMarq will accept the code. Anything else needs to be assigned to that ViewMarq via its software.
+
+VMCanvas levels;  //pixels for the whole display
+
+const uint8_t drop[] = { 0x10, 0x38, 0x7C, 0xFE, 0xFE, 0x7C, 0x38 };  //7 x 7 icon, one byte per row
+
+void setup() {
+  Ethernet.begin(mac);  //begin ethernet communications
+  Serial.begin(9600);   //begin serial communications
+
+  levels.drawBitmap(0, 12, drop, 7, 7, AMBER);  //icon to the left of the bar
+  levels.drawRect(10, 8, 202, 16, AMBER);       //outline of the bar, sized so the whole message fits in VM_MAX_COMMAND
+}
+
+int level = 0;
+
+void loop() {
+  levels.fillRect(11, 9, level, 14, (level > 150) ? RED : GREEN);  //filled part of the bar
+  levels.fillRect(11 + level, 9, 200 - level, 14, PIXEL_OFF);     //empty part of the bar
+  if(levels.isDirty()) {                //only write a message when pixels changed
+    sign.beginMessage();
+    sign.canvas(levels);
+    if(!sign.endMessage()) {
+      Serial.println("Message too long!");
+    }
+  }
+  sign.sendMessage();                   //sends only if a new message was written
+  level = (level + 4) % 201;
+  delay(500);
+}
@@ -0,0 +1,67 @@
+/************************************************
+Written for FACTS Engineering
+Copyright (c) 2019 FACTS Engineering, LLC
+Licensed under the MIT license.
+************************************************/
+
+#include <ViewMarq.h>
+
+//This example program shows how to use the ViewMarq Arduino library to record every
+//modbus transaction sent to a ViewMarq display and replay them four times faster,
+//using an Arduino Microprocessor and an Arduino Ethernet shield. The log is kept in
+//memory here, but any Print and Stream, like a file on an SD card, can be used.
+
+IPAddress address(192, 168, 0, 182); // update with the IP Address of your Modbus server
+
+byte mac[6] = { 0xDE, 0xAD, 0xBE, 0xEF, 0xFE, 0xEF }; //change if there are any devices on your network with this MAC address
+
+EthernetClient signClient;
+
+VMDisplay sign(0, signClient, address);  //initialize the VMDisplay with its ID, communications client, and IPAddress.
+//if the ID is 0, any ViewMarq will accept the code. Anything else needs to be assigned to that ViewMarq via its software.
+
+class MemoryLog : public Stream {  //a log held in memory
+  public:
+    uint8_t data[1024];
+    size_t length = 0;
+    size_t position = 0;
+    size_t write(uint8_t c) {
+      if(length >= sizeof(data)) {
+        return 0;
+      }
+      data[length++] = c;
+      return 1;
+    }
+    int available() { return length - position; }
+    int read() { return (position < length) ? data[position++] : -1; }
+    int peek() { return (position < length) ? data[position] : -1; }
+    void flush() {}
+};
+
+MemoryLog capture;
+
+void setup() {
+  Ethernet.begin(mac);  //begin ethernet communications
+  Serial.begin(9600);   //begin serial communications
+
+  sign.writeMessage("<ID 0><CLR><WIN 0 0 287 31><POS 0 0><CJ><BL N><CS 3><GRN><DEC 1 3 0>");
+  sign.setCapture(&capture);            //record from here on
+  sign.sendMessage();
+  for(long int i = 1; i <= 10; i++) {   //record ten updates, one second apart
+    sign.updateDecimal(1, i, false);
+    delay(1000);
+  }
+  sign.setCapture(NULL);                //stop recording
+  Serial.print("Recorded ");
+  Serial.print(capture.length);
+  Serial.println(" bytes.");
+}
+
+void loop() {
+  capture.position = 0;                 //replay from the start
+  long int replayed = sign.replayCapture(capture, 4);  //four times faster than recorded
+  Serial.print("Replayed ");
+  Serial.print(replayed);
+  Serial.println(" transactions.");
+  delay(5000);
+}
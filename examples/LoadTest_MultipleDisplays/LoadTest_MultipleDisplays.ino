@@ -0,0 +1,245 @@
+/************************************************
+Written for FACTS Engineering
+Copyright (c) 2019 FACTS Engineering, LLC
+Licensed under the MIT license.
+************************************************/
+
+#include <ViewMarq.h>
+
+//This example program is a soak test for several ViewMarq displays using an Arduino
+//Microprocessor and an Arduino Ethernet shield. It keeps every display busy with a mix
+//of full message rewrites, bursts of decimal updates, and string updates. Every ten
+//seconds it prints the operations per second, the 50th and 99th percentile time of
+//each kind of update, the most stack used so far, and the memory in use. Leave it
+//running to find the update rate your displays and network can sustain.
+
+#define DISPLAYS 3          //displays to drive, each needs its own address below
+#define BUCKETS 84          //latency histogram, four buckets per doubling of time up to 4 seconds
+#define REPORT_EVERY 10000  //milliseconds between reports
+
+IPAddress addresses[DISPLAYS] = {  // update with the IP Addresses of your displays
+  IPAddress(192, 168, 0, 182),
+  IPAddress(192, 168, 0, 183),
+  IPAddress(192, 168, 0, 184)
+};
+
+byte mac[6] = { 0xDE, 0xAD, 0xBE, 0xEF, 0xFE, 0xEF }; //change if there are any devices on your network with this MAC address
+
+EthernetClient clients[DISPLAYS];  //each display needs its own communications client
+
+VMDisplay signs[DISPLAYS] = {
+  { 0, clients[0], addresses[0] },
+  { 0, clients[1], addresses[1] },
+  { 0, clients[2], addresses[2] }
+};
+
+enum { REWRITE, DECIMALS, STRING, KINDS };
+const char *kindNames[KINDS] = { "rewrite ", "decimals", "string  " };
+
+struct Histogram {  //operation times, so percentiles don't need every sample kept
+  uint32_t counts[BUCKETS + 1];  //the last bucket holds everything slower
+  uint32_t total;
+} histograms[KINDS];
+
+unsigned long reportTime = 0;
+uint32_t intervalOperations = 0;
+long int counter = 0;
+
+//Stack high-water mark: on boards with a single stack right above the heap, fill the
+//free memory below the stack with a pattern once, then find how far down the pattern
+//has been overwritten. Boards running loop in an RTOS task have its stack somewhere
+//else, so the ESP32 asks FreeRTOS instead and other boards skip the measurement.
+#if defined(__AVR__) || defined(ARDUINO_ARCH_SAMD)
+#define PAINT_STACK
+#define PAINT 0xA5
+#if defined(__AVR__)
+extern char *__brkval;
+extern char __heap_start;
+char *heapEnd() { return __brkval ? __brkval : &__heap_start; }
+#else
+extern "C" char *sbrk(int increment);
+char *heapEnd() { return sbrk(0); }
+#endif
+char *paintBottom;
+char *paintTop;
+
+void paintStack() {
+  char here;
+  paintBottom = heapEnd() + 64;  //leave room for the heap to grow
+  paintTop = &here - 64;         //leave this function's frame alone
+  for(char *p = paintBottom; p < paintTop; p++) {
+    *p = PAINT;
+  }
+}
+
+long int stackUsed() {
+  char *p = paintBottom;
+  while(p < paintTop && *p == (char)PAINT) {
+    p++;
+  }
+  return paintTop - p;  //bytes of the painted region that were overwritten
+}
+
+long int freeMemory() {  //gap between the heap and the stack
+  char here;
+  return &here - heapEnd();
+}
+#endif
+
+//Bucket for a time in microseconds. Times under 8 get a bucket each, longer times are
+//split into four buckets per doubling, so every bucket is within 25% of its times.
+int bucketOf(unsigned long micro) {
+  if(micro < 8) {
+    return micro;
+  }
+  int shift = 1;
+  while((micro >> shift) >= 8) {
+    shift++;
+  }
+  int bucket = 8 + (shift - 1) * 4 + (int)(micro >> shift) - 4;
+  return (bucket < BUCKETS) ? bucket : BUCKETS;
+}
+
+unsigned long bucketLimit(int bucket) {  //longest time in a bucket, in microseconds
+  if(bucket < 8) {
+    return bucket;
+  }
+  int shift = (bucket - 8) / 4 + 1;
+  return ((unsigned long)((bucket - 8) % 4 + 5) << shift) - 1;
+}
+
+void record(int kind, unsigned long micro) {
+  histograms[kind].counts[bucketOf(micro)]++;
+  histograms[kind].total++;
+  intervalOperations++;
+}
+
+int percentile(int kind, int percent) {  //bucket, or -1 if there are no samples
+  uint32_t target = (histograms[kind].total * percent + 99) / 100;
+  uint32_t seen = 0;
+  for(int i = 0; i <= BUCKETS; i++) {
+    seen += histograms[kind].counts[i];
+    if(seen >= target && seen) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+void printPercentile(int kind, int percent) {  //as the longest time it could be
+  int bucket = percentile(kind, percent);
+  if(bucket < 0) {
+    Serial.print("-");
+  }
+  else if(bucket == BUCKETS) {
+    Serial.print(">");
+    Serial.print(bucketLimit(BUCKETS - 1));
+  }
+  else {
+    Serial.print(bucketLimit(bucket));
+  }
+  Serial.print(" us");
+}
+
+void report() {
+  Serial.print("ops/s: ");
+  Serial.println(intervalOperations * 1000.0 / REPORT_EVERY);
+  for(int kind = 0; kind < KINDS; kind++) {
+    Serial.print(kindNames[kind]);
+    Serial.print(" count ");
+    Serial.print(histograms[kind].total);
+    Serial.print(" p50 ");
+    printPercentile(kind, 50);
+    Serial.print(" p99 ");
+    printPercentile(kind, 99);
+    Serial.println();
+  }
+  Serial.print("display objects: ");
+  Serial.print((long)sizeof(signs));
+  Serial.println(" bytes");
+#if defined(PAINT_STACK)
+  Serial.print("stack high-water: ");
+  Serial.print(stackUsed());
+  Serial.println(" bytes");
+  Serial.print("free memory: ");
+  Serial.print(freeMemory());
+  Serial.println(" bytes");
+#elif defined(ESP32)
+  Serial.print("least stack free: ");
+  Serial.print((long)uxTaskGetStackHighWaterMark(NULL));  //bytes on the ESP32
+  Serial.println(" bytes");
+  Serial.print("free heap: ");
+  Serial.print((long)ESP.getFreeHeap());
+  Serial.print(" bytes, least ever: ");
+  Serial.print((long)ESP.getMinFreeHeap());
+  Serial.println(" bytes");
+#else
+  Serial.println("stack and memory use aren't measured on this board");
+#endif
+  intervalOperations = 0;
+}
+
+void buildLayout(VMDisplay &sign, int color) {  //four decimals on the left, a string on the right
+  sign.beginMessage();
+  sign.win(0, 0, 143, 31);
+  sign.pos(0, 0);
+  sign.scroll(LEFT_JUSTIFIED);
+  sign.blink(NONE);
+  sign.font(0);
+  sign.color(color);
+  for(int v = 1; v <= 4; v++) {
+    sign.dec(v, 6, 0);
+  }
+  sign.win(144, 0, 287, 31);
+  sign.pos(144, 0);
+  sign.str(1, 20);
+  if(!sign.endMessage()) {
+    Serial.println("Message too long!");
+  }
+}
+
+void setup() {
+  Ethernet.begin(mac);  //begin ethernet communications
+  Serial.begin(115200); //begin serial communications
+#if defined(PAINT_STACK)
+  paintStack();
+#endif
+
+  for(int i = 0; i < DISPLAYS; i++) {
+    clients[i].setConnectionTimeout(250);
+    buildLayout(signs[i], GREEN);
+  }
+  VMDisplay::startDisplays(60000);
+  reportTime = millis();
+}
+
+void loop() {
+  for(int i = 0; i < DISPLAYS; i++) {
+    int roll = random(100);
+    unsigned long start = micros();
+    if(roll < 10) {                     //10%: rebuild and send the whole message
+      buildLayout(signs[i], (counter % 2) ? AMBER : GREEN);
+      signs[i].sendMessage();
+      record(REWRITE, micros() - start);
+    }
+    else if(roll < 80) {                //70%: a burst of four decimal updates
+      for(int v = 1; v <= 4; v++) {
+        signs[i].updateDecimal(v, counter + v, false);
+      }
+      record(DECIMALS, micros() - start);
+    }
+    else {                              //20%: a formatted string update
+      VMFormat format;
+      format.decimals = 1;
+      format.separator = ',';
+      format.suffix = " l/min";
+      signs[i].formatStringVar(1, counter, format, false);
+      record(STRING, micros() - start);
+    }
+    counter++;
+  }
+  if(millis() - reportTime >= REPORT_EVERY) {
+    report();
+    reportTime = millis();
+  }
+}
@@ -0,0 +1,53 @@
+/************************************************
+Written for FACTS Engineering
+Copyright (c) 2019 FACTS Engineering, LLC
+Licensed under the MIT license.
+************************************************/
+
+#include <ViewMarq.h>
+
+//This example program shows how to bring up several ViewMarq displays at once using an
+//Arduino Microprocessor and an Arduino Ethernet shield. A display that is still booting
+//doesn't hold up the others, and the time each display took to show its message is printed.
+
+IPAddress addressA(192, 168, 0, 182); // update with the IP Addresses of your displays
+IPAddress addressB(192, 168, 0, 183);
+IPAddress addressC(192, 168, 0, 184);
+
+byte mac[6] = { 0xDE, 0xAD, 0xBE, 0xEF, 0xFE, 0xEF }; //change if there are any devices on your network with this MAC address
+
+EthernetClient clientA;  //each display needs its own communications client
+EthernetClient clientB;
+EthernetClient clientC;
+
+VMDisplay signA(0, clientA, addressA);
+VMDisplay signB(0, clientB, addressB);
+VMDisplay signC(0, clientC, addressC);
+
+void setup() {
+  Ethernet.begin(mac);  //begin ethernet communications
+  Serial.begin(9600);   //begin serial communications
+
+  clientA.setConnectionTimeout(250);  //keep each connection attempt short
+  clientB.setConnectionTimeout(250);
+  clientC.setConnectionTimeout(250);
+
+  signA.setText(1, "Line A");         //write every message before starting the displays
+  signA.writeMessage();
+  signB.setText(1, "Line B");
+  signB.writeMessage();
+  signC.setText(1, "Line C");
+  signC.writeMessage();
+
+  int started = VMDisplay::startDisplays(60000);  //keep trying for up to a minute
+  Serial.print(started);
+  Serial.println(" displays started.");
+  VMDisplay::printStartupReport();    //print how long each display took
+}
+
+void loop() {
+  signA.maintain();                   //resend a display's state if it restarts
+  signB.maintain();
+  signC.maintain();
+  delay(1000);
+}
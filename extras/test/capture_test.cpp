@@ -0,0 +1,141 @@
+/************************************************
+Written for FACTS Engineering
+Copyright (c) 2019 FACTS Engineering, LLC
+Licensed under the MIT license.
+************************************************/
+
+//Tests of setCapture and replayCapture. A mix of writes, reads, and failed transactions
+//to a pretend display is captured, the log is checked record by record, and then it is
+//replayed into a second pretend display, which must end up holding the same registers.
+//Build and run it with run_tests.sh.
+
+#include "ViewMarq.h"
+
+HardwareSerial Serial;
+unsigned long now = 0;	//milliseconds, moved forward by delay and yield
+
+unsigned long millis() { return now; }
+unsigned long micros() { return now * 1000; }
+void delay(unsigned long ms) { now += ms; }
+void delayMicroseconds(unsigned int us) {}
+void yield() { now++; }
+
+int failures = 0;
+
+#define CHECK(condition) do { if(!(condition)) { printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); failures++; } } while(0)
+
+class Log : public Stream {	//a log kept in memory, written as a Print and read back as a Stream
+	public:
+		uint8_t bytes[16384];
+		size_t length = 0;
+		size_t position = 0;
+		size_t write(uint8_t c) {
+			if(length == sizeof(bytes)) {
+				return 0;
+			}
+			bytes[length++] = c;
+			return 1;
+		}
+		int available() { return length - position; }
+		int read() { return (position < length) ? bytes[position++] : -1; }
+		int peek() { return (position < length) ? bytes[position] : -1; }
+};
+
+const char *longMessage(char letter) {	//long enough to take two transactions
+	static char text[400];
+	strcpy(text, "<ID 0><CLR><T>");
+	int length = strlen(text);
+	memset(text + length, letter, 300);
+	strcpy(text + length + 300, "</T>");
+	return text;
+}
+
+void testCaptureAndReplay() {
+	PretendDisplay original;
+	IPAddress ip(192, 168, 0, 182);
+	VMDisplay sign(0, original, ip);
+	Log log;
+	sign.setCapture(&log);
+
+	sign.writeMessage(longMessage('A'));
+	CHECK(sign.sendMessage());
+	sign.updateDecimal(1, 0x12345L, false);
+	sign.updateDecimal(2, -7L, false);
+	sign.updateStringVar(1, "abc", false);
+	sign.writeMessage(longMessage('B'));
+	original.failAt = original.transactions + 1;	//the second chunk fails
+	CHECK(!sign.sendMessage());
+	CHECK(sign.sendMessage());
+	CHECK(sign.verifyMessage() == VERIFY_OK);
+	original.failAt = original.transactions;	//the read of the decimal variables fails
+	CHECK(sign.verifyVariables() == VERIFY_UNAVAILABLE);
+	CHECK(sign.verifyVariables() == VERIFY_OK);
+	sign.setCapture(NULL);
+
+	//Walk the log, checking each record against what the pretend display holds.
+	CHECK(log.length > 4 && memcmp(log.bytes, "VMC1", 4) == 0);
+	int writes = 0, failedWrites = 0, reads = 0, failedReads = 0;
+	size_t at = 4;
+	while(at + 8 <= log.length) {
+		uint8_t *header = &log.bytes[at];
+		int address = header[4] | (header[5] << 8);
+		int count = header[6];
+		uint8_t status = header[7];
+		at += 8;
+		bool registers = !(status & CAPTURE_READ) || (status & CAPTURE_SUCCEEDED);
+		if(status & CAPTURE_READ) {
+			(status & CAPTURE_SUCCEEDED) ? reads++ : failedReads++;
+		}
+		else {
+			(status & CAPTURE_SUCCEEDED) ? writes++ : failedWrites++;
+		}
+		if((status & CAPTURE_READ) && (status & CAPTURE_SUCCEEDED)) {	//reads hold what the display held
+			for(int i = 0; i < count; i++) {
+				CHECK((log.bytes[at + i * 2] | (log.bytes[at + i * 2 + 1] << 8)) == original.registers[address + i]);
+			}
+		}
+		at += registers ? count * 2 : 0;
+	}
+	CHECK(at == log.length);
+	CHECK(writes == 8);	//three sends of two chunks, two decimals, and a string, less the failed chunk
+	CHECK(failedWrites == 1);
+	CHECK(failedReads == 1);
+	CHECK(reads > 0);
+	CHECK(writes + failedWrites + reads + failedReads == original.transactions);
+
+	//Replay into a display that was never written.
+	PretendDisplay replayed;
+	VMDisplay player(0, replayed, ip);
+	CHECK(player.replayCapture(log, 0) == writes + failedWrites);
+	CHECK(memcmp(replayed.registers, original.registers, sizeof(original.registers)) == 0);
+	CHECK(replayed.transactions == writes + failedWrites);	//reads are skipped
+}
+
+void testReplayRejectsBadLogs() {
+	PretendDisplay pretend;
+	IPAddress ip(192, 168, 0, 182);
+	VMDisplay sign(0, pretend, ip);
+	Log log;
+	memcpy(log.bytes, "VMC2", 4);
+	log.length = 4;
+	CHECK(sign.replayCapture(log, 0) == -1);
+
+	Log cut;
+	sign.setCapture(&cut);
+	sign.updateDecimal(1, 5L, false);
+	sign.updateDecimal(2, 6L, false);
+	sign.setCapture(NULL);
+	cut.length -= 2;	//ends in the middle of the second write
+	PretendDisplay replayed;
+	VMDisplay player(0, replayed, ip);
+	CHECK(player.replayCapture(cut, 0) == 1);
+	CHECK(replayed.registers[100] == 5);
+	CHECK(replayed.registers[102] == 0);
+}
+
+int main() {
+	testCaptureAndReplay();
+	testReplayRejectsBadLogs();
+	printf("capture_test: %d failed\n", failures);
+	return failures ? 1 : 0;
+}
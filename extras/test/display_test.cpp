@@ -0,0 +1,180 @@
+/************************************************
+Written for FACTS Engineering
+Copyright (c) 2019 FACTS Engineering, LLC
+Licensed under the MIT license.
+************************************************/
+
+//Tests of sending messages to pretend displays that fail transactions or are still
+//booting. Build and run it with run_tests.sh.
+
+#include "ViewMarq.h"
+
+HardwareSerial Serial;
+unsigned long now = 0;	//milliseconds, moved forward by delay
+
+unsigned long millis() { return now; }
+unsigned long micros() { return now * 1000; }
+void delay(unsigned long ms) { now += ms; }
+void delayMicroseconds(unsigned int us) {}
+void yield() { now++; }
+
+int failures = 0;
+
+#define CHECK(condition) do { if(!(condition)) { printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); failures++; } } while(0)
+
+//The message a pretend display holds, up to the end carriage characters.
+const char *shown(PretendDisplay &display) {
+	static char text[VM_MAX_COMMAND + 2];
+	int length = 0;
+	for(int r = 10999; length < VM_MAX_COMMAND; r++) {
+		text[length++] = display.registers[r] & 0xFF;
+		text[length++] = display.registers[r] >> 8;
+		if(memchr(&text[length - 2], 0x0D, 2) != NULL) {
+			break;
+		}
+	}
+	text[length] = 0;
+	*strchr(text, 0x0D) = 0;
+	return text;
+}
+
+//A message of one letter repeated, long enough to take two transactions.
+const char *longMessage(char letter) {
+	static char text[400];
+	strcpy(text, "<ID 0><CLR><T>");
+	int length = strlen(text);
+	memset(text + length, letter, 300);
+	strcpy(text + length + 300, "</T>");
+	return text;
+}
+
+void testFailedChunkResendsMessage() {
+	PretendDisplay pretend;
+	IPAddress ip(192, 168, 0, 182);
+	VMDisplay sign(0, pretend, ip);
+	sign.writeMessage(longMessage('A'));
+	CHECK(sign.sendMessage());
+	CHECK(strcmp(shown(pretend), longMessage('A')) == 0);
+
+	sign.writeMessage(longMessage('B'));
+	pretend.failAt = pretend.transactions + 1;	//the second chunk fails
+	CHECK(!sign.sendMessage());
+	long sent = pretend.transactions;
+	CHECK(sign.sendMessage());	//the whole message is sent again
+	CHECK(pretend.transactions == sent + 2);
+	CHECK(strcmp(shown(pretend), longMessage('B')) == 0);
+	CHECK(sign.sendMessage());	//and only once
+	CHECK(pretend.transactions == sent + 2);
+}
+
+void testStartRetriesFailedSend() {
+	PretendDisplay pretendA, pretendB;
+	IPAddress ipA(192, 168, 0, 182), ipB(192, 168, 0, 183);
+	VMDisplay signA(1, pretendA, ipA);
+	VMDisplay signB(2, pretendB, ipB);
+	signA.writeMessage("<ID 1><CLR><T>A</T>");
+	signB.writeMessage("<ID 2><CLR><T>B</T>");
+	pretendB.failAt = 0;	//connects, but its modbus server doesn't answer the first send
+	CHECK(VMDisplay::startDisplays(1000) == 2);
+	CHECK(strcmp(shown(pretendA), "<ID 1><CLR><T>A</T>") == 0);
+	CHECK(strcmp(shown(pretendB), "<ID 2><CLR><T>B</T>") == 0);
+	CHECK(pretendB.transactions == 2);
+	CHECK(signB.startupTime() > signA.startupTime());
+
+	signA.writeMessage("<ID 1><CLR><T>C</T>");
+	pretendA.down = true;
+	CHECK(VMDisplay::startDisplays(1000) == 1);	//B has nothing new to send, A never answers
+	CHECK(signA.startupTime() == 0);
+}
+
+void testMaintainNoticesRestart() {
+	PretendDisplay pretend;
+	IPAddress ip(192, 168, 0, 182);
+	VMDisplay sign(0, pretend, ip);
+	sign.writeMessage("<ID 0><CLR><DEC 1 4 0>");
+	sign.sendMessage();
+	sign.updateDecimal(1, 42L, false);
+	CHECK(!sign.maintain());	//the new session is checked, and the message is there
+
+	memset(pretend.registers, 0, sizeof(pretend.registers));	//restarts while the session looks open
+	CHECK(!sign.maintain());	//not checked again yet
+	now += VM_PROBE_INTERVAL;
+	CHECK(sign.maintain());
+	CHECK(strcmp(shown(pretend), "<ID 0><CLR><DEC 1 4 0>") == 0);
+	CHECK(pretend.registers[100] == 42);
+
+	now += VM_PROBE_INTERVAL;
+	pretend.down = true;	//a failed read isn't a lost message
+	CHECK(!sign.maintain());
+	pretend.down = false;
+	long made = pretend.transactions;
+	CHECK(!sign.maintain());	//checked again in the new session, nothing is resent
+	CHECK(pretend.transactions == made + 2);
+}
+
+void testHandWrittenMessageDropsAlarms() {
+	PretendDisplay pretend;
+	IPAddress ip(192, 168, 0, 182);
+	VMDisplay sign(0, pretend, ip);
+	sign.beginMessage();
+	sign.win(0, 0, 287, 31);
+	sign.alarm(2, 800, 750);
+	sign.dec(2, 4, 0);
+	sign.endMessage();
+	sign.sendMessage();
+	sign.writeMessage("<ID 0><CLR><WIN 0 0 287 31><RED><DEC 2 4 0>");
+	sign.sendMessage();
+	sign.updateDecimal(2, 900L, false);	//past the old alarm's limit
+	CHECK(strcmp(shown(pretend), "<ID 0><CLR><WIN 0 0 287 31><RED><DEC 2 4 0>") == 0);
+}
+
+void testHandWrittenMessageDropsThresholds() {
+	PretendDisplay pretend;
+	IPAddress ip(192, 168, 0, 182);
+	VMDisplay sign(0, pretend, ip);
+	sign.beginMessage();
+	sign.win(0, 0, 287, 31);
+	sign.threshold(2, 500, GREEN, AMBER);
+	sign.dec(2, 4, 0);
+	sign.endMessage();
+	sign.updateDecimal(2, 100L, false);
+	sign.writeMessage("<ID 0><CLR><WIN 0 0 287 31><RED><DEC 2 4 0><T>psi</T>");
+	sign.sendMessage();
+	sign.updateDecimal(2, 900L, false);	//crosses the old threshold
+	CHECK(strcmp(shown(pretend), "<ID 0><CLR><WIN 0 0 287 31><RED><DEC 2 4 0><T>psi</T>") == 0);
+}
+
+void testBuiltMessageIsSentAsBuilt() {
+	PretendDisplay pretend;
+	IPAddress ip(192, 168, 0, 182);
+	VMDisplay sign(0, pretend, ip);
+	for(int letters = 1; letters <= 2; letters++) {	//ending on either half of a register
+		sign.beginMessage();
+		sign.win(0, 0, 287, 31);
+		sign.text(letters == 1 ? "a" : "ab");
+		CHECK(sign.endMessage());
+		CHECK(sign.sendMessage());
+		char built[VM_MAX_COMMAND];
+		sign.returnMessage(built);
+		CHECK(strcmp(shown(pretend), built) == 0);
+	}
+
+	sign.setText(1, "Hi");	//the line layout still writes into a caller's array
+	char message[VM_MAX_COMMAND];
+	int length = sign.generateString(message);
+	char line[VM_MAX_COMMAND];
+	int written = sign.lineConfig(0, 0, line);
+	CHECK(written > 0 && written == length - (int)strlen("<ID 0><CLR>"));
+	CHECK(memcmp(line, message + strlen("<ID 0><CLR>"), written) == 0);
+}
+
+int main() {
+	testBuiltMessageIsSentAsBuilt();
+	testFailedChunkResendsMessage();
+	testStartRetriesFailedSend();
+	testMaintainNoticesRestart();
+	testHandWrittenMessageDropsAlarms();
+	testHandWrittenMessageDropsThresholds();
+	printf("display_test: %d failed\n", failures);
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,201 @@
+/************************************************
+Written for FACTS Engineering
+Copyright (c) 2019 FACTS Engineering, LLC
+Licensed under the MIT license.
+************************************************/
+
+//Load test that runs on a desktop computer. It drives several pretend displays with the
+//same mix of updates as the LoadTest_MultipleDisplays example: full message rewrites,
+//bursts of decimal updates, and string updates. Each transaction takes a set amount of
+//simulated time, added to the time the library really takes. At the end it prints the
+//operations per second, the 50th and 99th percentile time of each kind of update, the
+//memory used by the display objects, and the most stack the updates used.
+//
+//Usage: load_test [displays] [microseconds per transaction] [simulated seconds]
+//Build and run it with run_tests.sh.
+
+#include "ViewMarq.h"
+#include <pthread.h>
+#include <time.h>
+
+#define BUCKETS 84	//four buckets per doubling of time, up to 4 seconds
+#define STACK_SIZE (256 * 1024)	//stack of the thread the updates run on
+#define PAINT 0xA5
+
+uint8_t stack[STACK_SIZE];
+long stackUsed = 0;	//bytes of the painted stack the updates overwrote
+
+HardwareSerial Serial;
+unsigned long simulated = 0;	//microseconds spent waiting on pretend displays
+struct timespec started;
+
+unsigned long micros() {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - started.tv_sec) * 1000000UL + (now.tv_nsec - started.tv_nsec) / 1000 + simulated;
+}
+unsigned long millis() { return micros() / 1000; }
+void delay(unsigned long ms) { simulated += ms * 1000; }
+void delayMicroseconds(unsigned int us) { simulated += us; }
+void yield() {}
+
+enum { REWRITE, DECIMALS, STRING, KINDS };
+const char *kindNames[KINDS] = { "rewrite ", "decimals", "string  " };
+
+struct Histogram {	//operation times, so percentiles don't need every sample kept
+	uint32_t counts[BUCKETS + 1];	//the last bucket holds everything slower
+	uint32_t total;
+} histograms[KINDS];
+
+int displayCount = 8;
+unsigned long latency = 500;
+unsigned long seconds = 10;
+long operations = 0;
+unsigned long elapsed = 0;
+int failed = 0;
+
+//Bucket for a time in microseconds. Times under 8 get a bucket each, longer times are
+//split into four buckets per doubling, so every bucket is within 25% of its times.
+int bucketOf(unsigned long micro) {
+	if(micro < 8) {
+		return micro;
+	}
+	int shift = 1;
+	while((micro >> shift) >= 8) {
+		shift++;
+	}
+	int bucket = 8 + (shift - 1) * 4 + (int)(micro >> shift) - 4;
+	return (bucket < BUCKETS) ? bucket : BUCKETS;
+}
+
+unsigned long bucketLimit(int bucket) {	//longest time in a bucket, in microseconds
+	if(bucket < 8) {
+		return bucket;
+	}
+	int shift = (bucket - 8) / 4 + 1;
+	return ((unsigned long)((bucket - 8) % 4 + 5) << shift) - 1;
+}
+
+void record(int kind, unsigned long micro) {
+	histograms[kind].counts[bucketOf(micro)]++;
+	histograms[kind].total++;
+	operations++;
+}
+
+long percentile(int kind, int percent) {	//longest time it could be, or -1 if there are no samples
+	uint32_t target = (histograms[kind].total * percent + 99) / 100;
+	uint32_t seen = 0;
+	for(int i = 0; i <= BUCKETS; i++) {
+		seen += histograms[kind].counts[i];
+		if(seen >= target && seen) {
+			return bucketLimit((i < BUCKETS) ? i : BUCKETS - 1);
+		}
+	}
+	return -1;
+}
+
+void buildLayout(VMDisplay &sign, int color) {	//four decimals on the left, a string on the right
+	sign.beginMessage();
+	sign.win(0, 0, 143, 31);
+	sign.pos(0, 0);
+	sign.scroll(LEFT_JUSTIFIED);
+	sign.blink(NONE);
+	sign.font(0);
+	sign.color(color);
+	for(int v = 1; v <= 4; v++) {
+		sign.dec(v, 6, 0);
+	}
+	sign.win(144, 0, 287, 31);
+	sign.pos(144, 0);
+	sign.str(1, 20);
+	if(!sign.endMessage()) {
+		printf("Message too long!\n");
+		failed++;
+	}
+}
+
+__attribute__((noinline)) uint8_t *belowFrame() {	//an address below the caller's stack frame
+	return (uint8_t *)__builtin_frame_address(0);
+}
+
+void *run(void *) {
+	PretendDisplay *pretend = new PretendDisplay[displayCount];
+	VMDisplay **signs = new VMDisplay *[displayCount];
+	for(int i = 0; i < displayCount; i++) {
+		pretend[i].latency = latency;
+		IPAddress ip(192, 168, 0, i + 1);
+		signs[i] = new VMDisplay(0, pretend[i], ip);
+		buildLayout(*signs[i], GREEN);
+	}
+	VMDisplay::startDisplays(60000);
+	uint8_t *paintTop = belowFrame() - 64;
+	for(volatile uint8_t *p = stack; p < paintTop; p++) {	//after setting up, which allocates memory
+		*p = PAINT;
+	}
+	srand(1);
+	unsigned long begin = micros();
+	for(long counter = 0; micros() - begin < seconds * 1000000UL; ) {
+		for(int i = 0; i < displayCount; i++, counter++) {
+			int roll = rand() % 100;
+			unsigned long start = micros();
+			if(roll < 10) {	//10%: rebuild and send the whole message
+				buildLayout(*signs[i], (counter % 2) ? AMBER : GREEN);
+				if(!signs[i]->sendMessage()) {
+					failed++;
+				}
+				record(REWRITE, micros() - start);
+			}
+			else if(roll < 80) {	//70%: a burst of four decimal updates
+				for(int v = 1; v <= 4; v++) {
+					signs[i]->updateDecimal(v, counter + v, false);
+				}
+				record(DECIMALS, micros() - start);
+			}
+			else {	//20%: a formatted string update
+				VMFormat format;
+				format.decimals = 1;
+				format.separator = ',';
+				format.suffix = " l/min";
+				signs[i]->formatStringVar(1, counter, format, false);
+				record(STRING, micros() - start);
+			}
+		}
+	}
+	elapsed = micros() - begin;
+	uint8_t *touched = stack;
+	while(touched < paintTop && *touched == PAINT) {	//the stack grows down
+		touched++;
+	}
+	stackUsed = paintTop - touched;
+	for(int i = 0; i < displayCount; i++) {
+		delete signs[i];
+	}
+	delete[] signs;
+	delete[] pretend;
+	return NULL;
+}
+
+int main(int argc, char *argv[]) {
+	displayCount = (argc > 1) ? atoi(argv[1]) : 8;
+	latency = (argc > 2) ? atol(argv[2]) : 500;
+	seconds = (argc > 3) ? atol(argv[3]) : 10;
+	clock_gettime(CLOCK_MONOTONIC, &started);
+
+	//Run the updates on a thread whose stack is painted, then find how much of it was
+	//overwritten.
+	pthread_attr_t attributes;
+	pthread_attr_init(&attributes);
+	pthread_attr_setstack(&attributes, stack, sizeof(stack));
+	pthread_t thread;
+	pthread_create(&thread, &attributes, run, NULL);
+	pthread_join(thread, NULL);
+	printf("load_test: %d displays, %lu us per transaction\n", displayCount, latency);
+	printf("ops/s: %.1f\n", operations * 1000000.0 / elapsed);
+	for(int kind = 0; kind < KINDS; kind++) {
+		printf("%s count %u p50 %ld us p99 %ld us\n", kindNames[kind], histograms[kind].total, percentile(kind, 50), percentile(kind, 99));
+	}
+	printf("display objects: %ld bytes\n", (long)(displayCount * sizeof(VMDisplay)));
+	printf("stack high-water: %ld bytes\n", stackUsed);
+	printf("load_test: %d failed\n", failed);
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,105 @@
+/************************************************
+Written for FACTS Engineering
+Copyright (c) 2019 FACTS Engineering, LLC
+Licensed under the MIT license.
+************************************************/
+
+//Tests of validateMessage, minimizeMessage, and compressMessage, which check and rewrite
+//command strings without talking to a display. Build and run it with run_tests.sh.
+
+#include "ViewMarq.h"
+
+HardwareSerial Serial;
+
+unsigned long millis() { return 0; }
+unsigned long micros() { return 0; }
+void delay(unsigned long ms) {}
+void delayMicroseconds(unsigned int us) {}
+void yield() {}
+
+int failures = 0;
+
+#define CHECK(condition) do { if(!(condition)) { printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); failures++; } } while(0)
+
+PretendDisplay pretend;
+IPAddress ip(192, 168, 0, 182);
+VMDisplay sign(0, pretend, ip);
+
+//Minimizes text into a fresh array, checking the result and the length returned.
+void checkMinimized(const char *text, const char *expected) {
+	char out[VM_MAX_COMMAND];
+	int length = sign.minimizeMessage(text, out, sizeof(out));
+	CHECK(length == (int)strlen(expected));
+	if(strcmp(out, expected)) {
+		printf("minimized %s\n   to     %s\n   not    %s\n", text, out, expected);
+		failures++;
+	}
+}
+
+void testMinimize() {
+	checkMinimized("<ID 0><CLR><GRN><T>a</T><GRN><T>b</T>", "<ID 0><CLR><GRN><T>a</T><T>b</T>");	//repeated color
+	checkMinimized("<CS 1><T>a</T><CS 1><T>b</T>", "<CS 1><T>a</T><T>b</T>");	//repeated text size
+	checkMinimized("<T>a</T><T></T><T>b</T>", "<T>a</T><T>b</T>");	//empty text field
+	checkMinimized("<GRN><CLR><GRN><T>a</T>", "<GRN><CLR><GRN><T>a</T>");	//clearing resets the color
+	checkMinimized("<WIN 0 0 287 7><LJ><T>a</T><WIN 0 8 287 15><LJ><T>b</T>", "<WIN 0 0 287 7><LJ><T>a</T><WIN 0 8 287 15><LJ><T>b</T>");	//a window resets justification
+	checkMinimized("<WIN 0 0 287 31><POS 0 0><T>a</T>", "<WIN 0 0 287 31><POS 0 0><T>a</T>");	//positions are only dropped when compressing
+
+	char text[VM_MAX_COMMAND] = "<RED><T>x</T><RED><BL F><BL F><T>y</T>";	//in place
+	CHECK(sign.minimizeMessage(text, text, sizeof(text)) == 27);
+	CHECK(strcmp(text, "<RED><T>x</T><BL F><T>y</T>") == 0);
+
+	char small[10];
+	CHECK(sign.minimizeMessage("<GRN><T>abc</T>", small, sizeof(small)) == -1);	//doesn't fit
+}
+
+//Compresses text into a fresh array, checking the result and the length returned.
+void checkCompressed(const char *text, const char *expected) {
+	char out[VM_MAX_COMMAND];
+	int length = sign.compressMessage(text, out, sizeof(out), NULL, NULL);
+	CHECK(length == (int)strlen(expected));
+	if(strcmp(out, expected)) {
+		printf("compressed %s\n   to      %s\n   not     %s\n", text, out, expected);
+		failures++;
+	}
+}
+
+void testCompress() {
+	checkCompressed("<ID 0><CLR><GRN><T>a</T><GRN><T>b</T>", "<ID 0><CLR><GRN><T>ab</T>");	//merged text fields
+	checkCompressed("<CS 1><T>a</T><CS 1><T>b</T>", "<CS 1><T>ab</T>");
+	checkCompressed("<T>a</T><RED><T>b</T>", "<T>a</T><RED><T>b</T>");	//a color between them keeps them apart
+	checkCompressed("<WIN 0 0 287 31><POS 0 0><T>a</T>", "<WIN 0 0 287 31><T>a</T>");	//already at the window's origin
+	checkCompressed("<WIN 0 0 287 31><T>a</T><POS 0 0><T>b</T>", "<WIN 0 0 287 31><T>a</T><POS 0 0><T>b</T>");	//no longer at the origin
+	checkCompressed("<WIN 0 0 287 7><LJ><T>a</T><WIN 0 0 287 7><LJ><T>c</T>", "<WIN 0 0 287 7><LJ><T>a</T><POS 0 0><LJ><T>c</T>");	//the position resets justification
+	checkCompressed("<WIN 0 0 287 7><SL><T>a</T><WIN 0 0 287 7><SL><T>c</T>", "<WIN 0 0 287 7><SL><T>a</T><POS 0 0><T>c</T>");	//but not scrolling
+	checkCompressed("<WIN 0 0 287 7><T>a</T><WIN 0 8 287 15><T>b</T>", "<WIN 0 0 287 7><T>a</T><WIN 0 8 287 15><T>b</T>");	//different windows
+
+	char text[VM_MAX_COMMAND] = "<WIN 0 0 287 31><POS 0 0><GRN><T>x</T><GRN><T>y</T><WIN 0 0 287 31><T>z</T>";	//in place
+	int before = 0;
+	int after = 0;
+	CHECK(sign.compressMessage(text, text, sizeof(text), &before, &after) == 47);
+	CHECK(strcmp(text, "<WIN 0 0 287 31><GRN><T>xy</T><POS 0 0><T>z</T>") == 0);
+	CHECK(before == 1 && after == 1);
+
+	char out[VM_MAX_COMMAND] = "untouched";
+	CHECK(sign.compressMessage("<T>a</T><T>b", out, sizeof(out), NULL, NULL) == -1);
+	CHECK(strcmp(out, "untouched") == 0);
+}
+
+void testInvalid() {
+	const char *invalid[] = { "<T>a", "<XYZ>", "<CS 12>", "<WIN 0 0 287>", "<GRN" };
+	for(unsigned i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+		CHECK(!sign.validateMessage(invalid[i]));
+		char out[VM_MAX_COMMAND] = "untouched";
+		CHECK(sign.minimizeMessage(invalid[i], out, sizeof(out)) == -1);
+		CHECK(strcmp(out, "untouched") == 0);	//checked before anything is written
+	}
+	CHECK(sign.validateMessage("<ID 0><CLR><WIN 0 0 287 31><POS 0 0><SL><S S><BL N><CS 0><RED><T>Hello</T><DEC 1 4 0>"));
+}
+
+int main() {
+	testMinimize();
+	testCompress();
+	testInvalid();
+	printf("message_test: %d failed\n", failures);
+	return failures ? 1 : 0;
+}
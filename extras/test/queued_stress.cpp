@@ -0,0 +1,99 @@
+/************************************************
+Written for FACTS Engineering
+Copyright (c) 2019 FACTS Engineering, LLC
+Licensed under the MIT license.
+************************************************/
+
+//Stress test for queued mode. A producer thread keeps writing messages of changing
+//length and flipping a decimal variable between two values, while the main thread
+//plays the network task: it calls poll and verifyVariables and, after every call,
+//checks that the pretend display never holds a torn message (one made of two
+//different messages) or a torn decimal (the high word of one value with the low
+//word of the other). The pretend display yields after every register, so the
+//producer runs in the middle of each transaction. Build and run it with run_tests.sh.
+
+#include "ViewMarq.h"
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+
+HardwareSerial Serial;
+
+unsigned long millis() { return 0; }
+unsigned long micros() { return 0; }
+void delay(unsigned long ms) {}
+void delayMicroseconds(unsigned int us) {}
+void yield() { sched_yield(); }
+
+PretendDisplay client;
+uint16_t *displayRegisters = client.registers;
+IPAddress ip(192, 168, 0, 182);
+VMDisplay sign(0, client, ip);
+volatile bool done = false;
+
+void *produce(void *) {
+	char message[400];
+	for(long int k = 0; !__atomic_load_n(&done, __ATOMIC_SEQ_CST); k++) {
+		char fill = 'A' + (k % 26);	//every message is one letter repeated, so mixing two shows
+		strcpy(message, "<ID 0><CLR><T>");
+		int length = strlen(message);
+		int letters = 100 + (k % 200);
+		memset(message + length, fill, letters);
+		strcpy(message + length + letters, "</T>");
+		sign.writeMessage(message);
+		if(k % 16 == 0) {	//rarely enough that a full queue doesn't hold the producer back
+			sign.updateDecimal(3, (k % 32) ? 0x12345678L : -1L, false);
+		}
+	}
+	return NULL;
+}
+
+bool messageTorn() {
+	int letter = -1;
+	for(int r = 10999 + 7; ; r++) {	//past "<ID 0><CLR><T>"
+		uint8_t low = displayRegisters[r] & 0xFF;
+		uint8_t high = displayRegisters[r] >> 8;
+		if(low == 0 || low == 0x0D || low == '<') {
+			return false;
+		}
+		if(letter < 0) {
+			letter = low;
+		}
+		if(low != letter) {
+			return true;
+		}
+		if(high == '<') {
+			return false;
+		}
+		if(high != letter) {
+			return true;
+		}
+	}
+}
+
+bool decimalTorn() {
+	uint32_t value = ((uint32_t)displayRegisters[99 + 4] << 16) | displayRegisters[100 + 4];
+	return value != 0x12345678UL && value != 0xFFFFFFFFUL && value != 0;
+}
+
+int main(int argc, char *argv[]) {
+	long int seconds = (argc > 1) ? atol(argv[1]) : 10;
+	long int checks = 0;
+	long int torn = 0;
+	sign.setQueued(true);
+	pthread_t producer;
+	pthread_create(&producer, NULL, produce, NULL);
+	time_t end = time(NULL) + seconds;
+	while(time(NULL) < end) {
+		sign.poll();
+		sign.verifyVariables();
+		if(messageTorn() || decimalTorn()) {
+			torn++;
+		}
+		checks++;
+	}
+	__atomic_store_n(&done, true, __ATOMIC_SEQ_CST);
+	pthread_join(producer, NULL);
+	printf("queued_stress: %ld checks, %ld torn\n", checks, torn);
+	return torn ? 1 : 0;
+}
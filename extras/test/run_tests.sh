@@ -0,0 +1,22 @@
+#!/bin/sh
+# Builds the ViewMarq library for the desktop against the stand-ins in stubs/ and runs
+# the tests in this folder. Pass a number of seconds to change how long the stress
+# test runs (10 by default). The stack use of the deepest call chain is checked last.
+set -e
+cd "$(dirname "$0")"
+CXX=${CXX:-g++}
+FLAGS="-std=gnu++11 -O1 -Wall -Wno-sign-compare -Istubs -I../../src"
+mkdir -p build
+$CXX $FLAGS ../../src/ViewMarq.cpp message_test.cpp -o build/message_test
+./build/message_test
+$CXX $FLAGS ../../src/ViewMarq.cpp display_test.cpp -o build/display_test
+./build/display_test
+$CXX $FLAGS ../../src/ViewMarq.cpp capture_test.cpp -o build/capture_test
+./build/capture_test
+$CXX $FLAGS ../../src/ViewMarq.cpp queued_stress.cpp -o build/queued_stress -lpthread
+./build/queued_stress "$@"
+# Bind every library function at startup, so the dynamic linker's first-call stack use
+# isn't counted in the load test's stack high-water mark.
+$CXX $FLAGS ../../src/ViewMarq.cpp load_test.cpp -o build/load_test -lpthread -Wl,-z,now
+./build/load_test 8 500 10
+python3 stack_check.py
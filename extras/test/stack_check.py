@@ -0,0 +1,78 @@
+#!/usr/bin/env python3
+"""Checks the worst case stack use of the ViewMarq library.
+
+Builds src/ViewMarq.cpp for this computer with g++ -Os, the optimization the Arduino
+IDE uses, and reads the stack use of every function and the calls between them from
+GCC's call graph (-fcallgraph-info=su). The deepest chain of calls from any function
+of the library must stay under the limit (640 bytes by default), the figure the
+README gives. Functions outside the library, like memcpy and the modbus client, are
+counted as using no stack. Calls through a function pointer or a virtual function
+aren't in the graph.
+
+Usage: stack_check.py [limit]
+"""
+
+import os
+import re
+import subprocess
+import sys
+import tempfile
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+SOURCE = os.path.join(HERE, "..", "..", "src", "ViewMarq.cpp")
+
+
+def build(directory):
+	output = os.path.join(directory, "ViewMarq.o")
+	subprocess.check_call([os.environ.get("CXX", "g++"), "-std=gnu++11", "-Os", "-c",
+						   "-fcallgraph-info=su", "-I" + os.path.join(HERE, "stubs"),
+						   "-I" + os.path.join(HERE, "..", "..", "src"), SOURCE, "-o", output])
+	with open(os.path.join(directory, "ViewMarq.ci")) as graph:
+		return graph.read()
+
+
+def parse(graph):
+	frames = {}	#stack bytes and name of each function of the library
+	calls = {}
+	for title, label in re.findall(r'node: \{ title: "([^"]*)" label: "([^"]*)"', graph):
+		size = re.search(r"\\n(\d+) bytes \((static|dynamic)", label)
+		if size:
+			frames[title] = (int(size.group(1)), label.split("\\n")[0])
+	for source, target in re.findall(r'edge: \{ sourcename: "([^"]*)" targetname: "([^"]*)"', graph):
+		calls.setdefault(source, set()).add(target)
+	return frames, calls
+
+
+def deepest(function, frames, calls, memo, active):
+	if function not in frames:	#outside the library
+		return 0, []
+	if function in memo:
+		return memo[function]
+	if function in active:
+		sys.exit("Recursion through " + frames[function][1] + ", stack use has no bound.")
+	active.add(function)
+	worst = (0, [])
+	for callee in calls.get(function, ()):
+		depth = deepest(callee, frames, calls, memo, active)
+		if depth[0] > worst[0]:
+			worst = depth
+	active.discard(function)
+	memo[function] = (frames[function][0] + worst[0], [function] + worst[1])
+	return memo[function]
+
+
+def main():
+	limit = int(sys.argv[1]) if len(sys.argv) > 1 else 640
+	with tempfile.TemporaryDirectory() as directory:
+		frames, calls = parse(build(directory))
+	memo = {}
+	worst = max((deepest(function, frames, calls, memo, set()) for function in frames), key=lambda depth: depth[0])
+	print("Deepest call chain uses %d bytes of stack (limit %d):" % (worst[0], limit))
+	for function in worst[1]:
+		print("  %5d  %s" % (frames[function][0], frames[function][1]))
+	if worst[0] >= limit:
+		sys.exit("Stack use is over the limit.")
+
+
+if __name__ == "__main__":
+	main()
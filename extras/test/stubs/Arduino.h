@@ -0,0 +1,99 @@
+/************************************************
+Written for FACTS Engineering
+Copyright (c) 2019 FACTS Engineering, LLC
+Licensed under the MIT license.
+************************************************/
+
+//Just enough of the Arduino core to build the ViewMarq library on a desktop computer
+//for the tests in extras/test. Serial prints to standard output.
+
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef uint8_t byte;
+
+#define PROGMEM
+#define pgm_read_byte(p) (*(const uint8_t *)(p))
+#define pgm_read_word(p) (*(const uint16_t *)(p))
+#define memcpy_P memcpy
+
+class Print {
+	public:
+		virtual size_t write(uint8_t c) { return 1; }
+		virtual size_t write(const uint8_t *buffer, size_t size) {
+			for(size_t i = 0; i < size; i++) {
+				write(buffer[i]);
+			}
+			return size;
+		}
+		size_t print(const char text[]) { return printf("%s", text); }
+		size_t print(char c) { return printf("%c", c); }
+		size_t print(int number) { return printf("%d", number); }
+		size_t print(unsigned int number) { return printf("%u", number); }
+		size_t print(long number) { return printf("%ld", number); }
+		size_t print(unsigned long number) { return printf("%lu", number); }
+		size_t print(double number) { return printf("%f", number); }
+		size_t println() { return printf("\n"); }
+		size_t println(const char text[]) { return printf("%s\n", text); }
+		size_t println(int number) { return printf("%d\n", number); }
+		size_t println(unsigned int number) { return printf("%u\n", number); }
+		size_t println(long number) { return printf("%ld\n", number); }
+		size_t println(unsigned long number) { return printf("%lu\n", number); }
+		size_t println(double number) { return printf("%f\n", number); }
+};
+
+class Stream : public Print {
+	public:
+		virtual int available() { return 0; }
+		virtual int read() { return -1; }
+		virtual int peek() { return -1; }
+		size_t readBytes(uint8_t *buffer, size_t length) {
+			size_t i = 0;
+			for(; i < length; i++) {
+				int c = read();
+				if(c < 0) {
+					break;
+				}
+				buffer[i] = c;
+			}
+			return i;
+		}
+};
+
+class HardwareSerial : public Stream {
+	public:
+		void begin(long baud) {}
+};
+
+extern HardwareSerial Serial;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+class IPAddress {
+	private:
+		uint8_t _octets[4];
+	public:
+		IPAddress() { memset(_octets, 0, 4); }
+		IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) {
+			_octets[0] = a;
+			_octets[1] = b;
+			_octets[2] = c;
+			_octets[3] = d;
+		}
+		uint8_t operator[](int i) const { return _octets[i]; }
+		uint8_t &operator[](int i) { return _octets[i]; }
+};
+
+class Client : public Stream {
+	public:
+		virtual int connect(IPAddress ip, uint16_t port) { return 1; }
+		virtual uint8_t connected() { return 1; }
+		virtual void stop() {}
+};
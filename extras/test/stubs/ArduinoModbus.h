@@ -0,0 +1,83 @@
+/************************************************
+Written for FACTS Engineering
+Copyright (c) 2019 FACTS Engineering, LLC
+Licensed under the MIT license.
+************************************************/
+
+//A ModbusTCPClient that talks to a PretendDisplay, the holding registers of a display
+//kept in memory. Pass a PretendDisplay to VMDisplay as its client. The pretend display
+//can be made to fail a transaction, to be down (still booting), and to take time for
+//each transaction. Set the VMTRACE environment variable to print each write as
+//"TX <first register> <count>".
+
+#pragma once
+#include "Arduino.h"
+
+#define HOLDING_REGISTERS 4
+
+class PretendDisplay : public Client {
+	public:
+		uint16_t registers[20000];
+		bool down = false;	//connections and transactions fail, like a display still booting
+		long transactions = 0;	//transactions made, reads included
+		long failAt = -1;	//transaction that fails (counting from 0), -1 if none
+		unsigned long latency = 0;	//microseconds each transaction takes, passed to delayMicroseconds
+		PretendDisplay() { memset(registers, 0, sizeof(registers)); }
+		bool transact() {	//counts a transaction, returning whether it succeeds
+			delayMicroseconds(latency);
+			return !down && transactions++ != failAt;
+		}
+};
+
+class ModbusTCPClient {
+	private:
+		PretendDisplay *_display;
+		int _address = 0;
+		int _count = 0;
+		uint16_t _pending[123];	//registers of the write in progress, stored if it succeeds
+		bool _connected = false;
+	public:
+		ModbusTCPClient(Client &client) : _display(dynamic_cast<PretendDisplay *>(&client)) {
+			if(_display == NULL) {
+				printf("Displays must be given a PretendDisplay as their client.\n");
+				abort();
+			}
+		}
+		int begin(IPAddress ip, uint16_t port = 502) {
+			delayMicroseconds(_display->latency);
+			_connected = !_display->down;
+			return _connected;
+		}
+		int connected() { return _connected; }
+		void stop() { _connected = false; }
+		long holdingRegisterRead(int address) {
+			return (_connected && _display->transact()) ? _display->registers[address] : -1;
+		}
+		int beginTransmission(int type, int address, int count) {
+			_address = address;
+			_count = 0;
+			if(getenv("VMTRACE")) {
+				printf("TX %d %d\n", address, count);
+			}
+			return 1;
+		}
+		int write(unsigned int value) {
+			if(_count < 123) {
+				_pending[_count++] = value;
+			}
+			yield();	//let other threads run in the middle of a transaction
+			return 1;
+		}
+		int endTransmission() {
+			if(!_connected || !_display->transact()) {
+				return 0;
+			}
+			memcpy(&_display->registers[_address], _pending, _count * sizeof(uint16_t));
+			return 1;
+		}
+		int requestFrom(int type, int address, int count) {
+			_address = address;
+			return (_connected && _display->transact()) ? count : 0;
+		}
+		long read() { return _display->registers[_address++]; }
+};
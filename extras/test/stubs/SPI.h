@@ -0,0 +1,2 @@
+//Empty stand-in, the library only needs the classes in Arduino.h and ArduinoModbus.h.
+#pragma once
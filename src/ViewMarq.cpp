@@ -32,8 +32,198 @@ SOFTWARE.
 #include <string.h>
 #include <cmath>
 
-Client *VMDisplay::client;	//initialize pointer to user defined client
-ModbusTCPClient VMDisplay::VMClient(*client);	//initialize modbus client with user defined client
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#define VM_BUILT_IN_PLACE 1	//chars built into a message buffer already pair up as its registers
+#else
+#define VM_BUILT_IN_PLACE 0
+#endif
+
+VMDisplay *VMDisplay::_displays[VM_MAX_DISPLAYS];	//every display constructed, for startDisplays
+int VMDisplay::_displayCount = 0;
+
+//fields of the ASCII command string, in the order of the TAG_ constants
+enum { TAG_ID, TAG_CLR, TAG_WIN, TAG_POS, TAG_SL, TAG_SR, TAG_SU, TAG_SD, TAG_LJ, TAG_CJ, TAG_RJ,
+	   TAG_S, TAG_BL, TAG_CS, TAG_GRN, TAG_RED, TAG_AMB, TAG_T, TAG_DEC, TAG_STR, TAG_MTN, TAG_COUNT };
+static const char *const tagNames[TAG_COUNT] = { "ID", "CLR", "WIN", "POS", "SL", "SR", "SU", "SD", "LJ", "CJ", "RJ",
+												 "S", "BL", "CS", "GRN", "RED", "AMB", "T", "DEC", "STR", "MTN" };
+static const uint8_t tagArgs[TAG_COUNT] = { 1, 0, 4, 2, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 0, 0, 0, 0, 3, 2, 1 };
+static const char speedLetters[] = "SMF";	//index matches SLOW, MEDIUM, FAST
+static const char blinkLetters[] = "SMFN";	//index matches SLOW, MEDIUM, FAST, NONE
+static const char colorNames[3][4] = { "GRN", "RED", "AMB" };	//index matches GREEN, RED, AMBER
+
+struct GlyphFallback {	//characters shown for a code point outside the display's Latin-1 set
+	uint16_t code;
+	char glyphs[4];
+};
+static constexpr GlyphFallback glyphFallbacks[] PROGMEM = {	//sorted by code point for the binary search
+	{ 0x0131, "i" }, { 0x0141, "L" }, { 0x0142, "l" }, { 0x0152, "OE" }, { 0x0153, "oe" },
+	{ 0x0160, "S" }, { 0x0161, "s" }, { 0x0178, "Y" }, { 0x017D, "Z" }, { 0x017E, "z" },
+	{ 0x02DA, "\xB0" }, { 0x0394, "D" }, { 0x03A9, "Ohm" }, { 0x03BC, "\xB5" },
+	{ 0x2002, " " }, { 0x2003, " " }, { 0x2009, " " }, { 0x2010, "-" }, { 0x2011, "-" },
+	{ 0x2012, "-" }, { 0x2013, "-" }, { 0x2014, "-" }, { 0x2018, "'" }, { 0x2019, "'" },
+	{ 0x201A, "," }, { 0x201C, "\"" }, { 0x201D, "\"" }, { 0x201E, "\"" }, { 0x2022, "\xB7" },
+	{ 0x2026, "..." }, { 0x202F, " " }, { 0x2032, "'" }, { 0x2033, "\"" }, { 0x2044, "/" },
+	{ 0x20AC, "EUR" }, { 0x2103, "\xB0" "C" }, { 0x2109, "\xB0" "F" }, { 0x2122, "TM" },
+	{ 0x2126, "Ohm" }, { 0x2190, "<" }, { 0x2191, "^" }, { 0x2192, ">" }, { 0x2193, "v" },
+	{ 0x2212, "-" }, { 0x2215, "/" }, { 0x2219, "\xB7" }, { 0x2248, "~" }, { 0x2260, "!=" },
+	{ 0x2264, "<=" }, { 0x2265, ">=" }
+};
+static const int glyphFallbackCount = sizeof(glyphFallbacks) / sizeof(glyphFallbacks[0]);
+
+static constexpr bool sortedFrom(int i) {
+	return i + 1 >= glyphFallbackCount || (glyphFallbacks[i].code < glyphFallbacks[i + 1].code && sortedFrom(i + 1));
+}
+static_assert(sortedFrom(0), "glyphFallbacks must be sorted by code point");
+
+/*******************************************************************************
+Description: Decodes the next UTF-8 character of a string. Invalid or cut off
+			 sequences decode as U+FFFD, resuming at the byte that broke them.
+
+Parameters: -const char **text - The string, advanced past the character.
+
+Returns: 	-The character's code point.
+
+Example Code:
+*******************************************************************************/
+static uint32_t decodeUTF8(const char **text) {
+	const uint8_t *c = (const uint8_t *)*text;
+	uint32_t code;
+	int extra;	//continuation bytes expected
+	if(c[0] < 0x80) {
+		*text += 1;
+		return c[0];
+	}
+	else if((c[0] & 0xE0) == 0xC0) {
+		code = c[0] & 0x1F;
+		extra = 1;
+	}
+	else if((c[0] & 0xF0) == 0xE0) {
+		code = c[0] & 0x0F;
+		extra = 2;
+	}
+	else if((c[0] & 0xF8) == 0xF0) {
+		code = c[0] & 0x07;
+		extra = 3;
+	}
+	else {	//stray continuation byte
+		*text += 1;
+		return 0xFFFD;
+	}
+	for(int i = 1; i <= extra; i++) {	//a null also ends the sequence here
+		if((c[i] & 0xC0) != 0x80) {
+			*text += i;
+			return 0xFFFD;
+		}
+		code = (code << 6) | (c[i] & 0x3F);
+	}
+	*text += extra + 1;
+	return code;
+}
+
+/*******************************************************************************
+Description: Finds the characters the display shows for a code point. Latin-1
+			 characters are shown as they are, others use glyphFallbacks, and
+			 anything else is shown as '?'. Control characters can't be shown,
+			 so they give no characters.
+
+Parameters: -uint32_t code - The code point.
+			-char glyphs[4] - Filled with up to three characters and a null.
+
+Returns: 	-Amount of characters written to glyphs.
+
+Example Code:
+*******************************************************************************/
+static int glyphsOf(uint32_t code, char glyphs[4]) {
+	glyphs[1] = 0;
+	if(code < 0x20 || (code >= 0x80 && code < 0xA0)) {
+		glyphs[0] = 0;
+		return 0;
+	}
+	if(code < 0x100) {
+		glyphs[0] = code;
+		return 1;
+	}
+	int low = 0;
+	int high = glyphFallbackCount - 1;
+	while(low <= high) {
+		int middle = (low + high) / 2;
+		uint16_t found = pgm_read_word(&glyphFallbacks[middle].code);
+		if(found == code) {
+			memcpy_P(glyphs, glyphFallbacks[middle].glyphs, 4);
+			return strlen(glyphs);
+		}
+		else if(found < code) {
+			low = middle + 1;
+		}
+		else {
+			high = middle - 1;
+		}
+	}
+	glyphs[0] = '?';
+	return 1;
+}
+
+static const char digitPairs[201] PROGMEM =	//two digit numbers, for converting numbers two digits at a time
+	"00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+	"40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+	"8081828384858687888990919293949596979899";
+
+static void packChar(uint16_t *registers, int index, char c) {	//two characters per register, first in the low byte
+	registers[index / 2] |= (uint16_t)(uint8_t)c << ((index % 2) * 8);
+}
+
+static int packText(uint16_t *registers, int chars, const char text[]) {	//decode UTF-8 after chars, up to 100 in total
+	char glyphs[4];
+	while(*text && chars < 100) {
+		int count = glyphsOf(decodeUTF8(&text), glyphs);
+		for(int i = 0; i < count && chars < 100; i++) {
+			packChar(registers, chars, glyphs[i]);
+			chars++;
+		}
+	}
+	return chars;
+}
+
+static bool isColorTag(const char *tag) {	//<GRN>, <RED>, or <AMB>
+	return tag[0] == '<' && (!strncmp(tag + 1, "GRN>", 4) || !strncmp(tag + 1, "RED>", 4) || !strncmp(tag + 1, "AMB>", 4));
+}
+
+/*******************************************************************************
+Description: Decodes UTF-8 text into the display's characters at the end of an
+			 array, stopping when the array is full.
+
+Parameters: -char *arr - The array, holding length characters already.
+			-int length - Characters in the array.
+			-int size - Size of the array, including the terminating null.
+			-const char text[] - UTF-8 text to decode.
+
+Returns: 	-The new amount of characters in the array.
+
+Example Code:
+*******************************************************************************/
+static int decodeInto(char *arr, int length, int size, const char text[]) {
+	char glyphs[4];
+	while(*text) {
+		int count = glyphsOf(decodeUTF8(&text), glyphs);
+		for(int i = 0; i < count && length < size - 1; i++) {
+			arr[length] = glyphs[i];
+			length++;
+		}
+	}
+	arr[length] = 0;
+	return length;
+}
+
+//display settings currently in effect while reading a command string, -1 when unknown
+enum { WIDGET_BAR, WIDGET_THRESHOLD, WIDGET_ALARM };
+
+struct VMState {
+	int color;
+	int blink;
+	int charSet;
+	int scrollType;
+	int scrollSpeed;
+};
 
 /*******************************************************************************
 Description: Turn one of the ViewMarq display's four lines on or off by selecting
@@ -97,18 +287,7 @@ void VMDisplay::setTextSize(int lineSelected, int textSize) {
 		Serial.println("Line selected must be between 1 and 4.");
 	}
 	else {
-		if(textSize == 0) {		//2 is actually the smallest character set
-			line[lineSelected - 1].textSize = 2;	//keep it ordered least to greatest
-		}
-		else if(textSize == 1) {
-			line[lineSelected - 1].textSize = 0;
-		}
-		else if(textSize == 2) {
-			line[lineSelected - 1].textSize = 1;
-		}
-		else {	//anything other than 0, 1, and 2 are ordered normally
-			line[lineSelected - 1].textSize = textSize;
-		}
+		line[lineSelected - 1].textSize = VMDisplay::charSetOf(textSize);	//keep it ordered least to greatest
 	}
 }
 
@@ -177,7 +356,9 @@ void VMDisplay::setBlink(int lineSelected, int blink) {
 
 /*******************************************************************************
 Description: Set the text field to be displayed on the selected line using the
-			 default or already specified properties.
+			 default or already specified properties. The text is UTF-8, and
+			 characters the display doesn't have are replaced (see glyphsOf). Up
+			 to 255 of the display's characters are kept.
 
 Parameters: -int lineSelected - Specifies the line you are interacting with.
 			-const char text[] - Enter a string literal with the text you would
@@ -193,10 +374,79 @@ void VMDisplay::setText(int lineSelected, const char text[]) {
 	}
 	else {
 		memset(line[lineSelected - 1].text, 0, 256);
-		for(int i = 0; i < strlen(text); i++) {
-			line[lineSelected - 1].text[i] = text[i];	//iterate and set the line's text field to the user defined text
-		}
+		decodeInto(line[lineSelected - 1].text, 0, 256, text);	//set the line's text field to the user defined text
+		line[lineSelected - 1].runCount = 0;	//the whole line uses the line's settings
+	}
+}
+
+/*******************************************************************************
+Description: Add text to the end of the selected line with its own color, text
+			 size, and blink, so that a single line can mix formats. Any setting
+			 given as LINE_DEFAULT uses the line's own setting. Only the settings
+			 that change from one part of the line to the next are written to the
+			 command string. A line holds up to VM_MAX_RUNS differently formatted
+			 parts, including the text set with setText.
+
+Parameters: -int lineSelected - Specifies the line you are interacting with.
+			-const char text[] - The text to add.
+			-int color - Use constants RED, GREEN, AMBER, and LINE_DEFAULT.
+			-int textSize - Enter between 0-11, or LINE_DEFAULT (defaultly).
+			-int blink - Use constants SLOW, MEDIUM, FAST, NONE, and LINE_DEFAULT
+			 (defaultly).
+
+Returns: 	-None
+
+Example Code:
+	sign.setText(1, "Rate: ");
+	sign.addText(1, "42", RED);
+	sign.addText(1, " u/min");
+*******************************************************************************/
+void VMDisplay::addText(int lineSelected, const char text[], int color, int textSize, int blink) {
+	if(lineSelected > 4 || lineSelected < 1) {
+		Serial.println("Line selected must be between 1 and 4.");
+		return;
+	}
+	Line &selected = line[lineSelected - 1];
+	int length = strlen(selected.text);
+	if(!text[0]) {
+		return;
+	}
+	if(!selected.runCount && length) {	//the text set with setText becomes the first part
+		selected.runs[0].start = 0;
+		selected.runs[0].color = LINE_DEFAULT;
+		selected.runs[0].textSize = LINE_DEFAULT;
+		selected.runs[0].blink = LINE_DEFAULT;
+		selected.runCount = 1;
+	}
+	if(selected.runCount >= VM_MAX_RUNS || length >= 255) {
+		Serial.println("Line has no room for more text.");
+		return;
+	}
+	Run &run = selected.runs[selected.runCount];
+	run.start = length;
+	run.color = color;
+	run.textSize = (textSize == LINE_DEFAULT) ? LINE_DEFAULT : VMDisplay::charSetOf(textSize);
+	run.blink = blink;
+	selected.runCount++;
+	decodeInto(selected.text, length, 256, text);
+}
+
+/*******************************************************************************
+Description: Finds the color a part of a line is shown in, using the line's color
+			 if the part doesn't have its own.
+
+Parameters: -int lineSelected - The line, 0-3.
+			-int run - The part of the line.
+
+Returns: 	-The color.
+
+Example Code:
+*******************************************************************************/
+int VMDisplay::runColor(int lineSelected, int run) {
+	if(run < line[lineSelected].runCount && line[lineSelected].runs[run].color != LINE_DEFAULT) {
+		return line[lineSelected].runs[run].color;
 	}
+	return line[lineSelected].color;
 }
 
 /*******************************************************************************
@@ -235,10 +485,11 @@ Returns: 	-None
 Example Code:
 *******************************************************************************/
 void VMDisplay::updateDecimal(int variable, const double actual, bool editBounds) {
+	VMDisplay::checkAlarms(variable, actual);
 	variable -= 1;	//subtract one because the variable is zero addressed
-	_decLoc = strstr(_commandString, "DEC");	//find location of DEC in the current command string
-	if(strstr(_commandString, "DEC") == NULL) {	//if the command string isn't displaying a decimal
-		editBounds = false;						//do not edit bounds
+	char *decField = VMDisplay::findField("DEC", variable + 1);	//find this variable's field in the current command string
+	if(decField == NULL) {	//if the command string isn't displaying this decimal
+		editBounds = false;	//do not edit bounds
 	}
 	int count = 0;	//variable for counting decimal places
 	double number = actual;	//temp value copy
@@ -262,29 +513,15 @@ void VMDisplay::updateDecimal(int variable, const double actual, bool editBounds
 	Serial.println();
 	*/
 
-	if(editBounds) {	//option to account for changes in decimal places
-		int digits = 0;	//digit counter
-		long int temporary = result;	//temp value copy
-		while(temporary) {	//while not zero
-			temporary /= 10;	//shift to the right
-			digits++;	//increment counter
-		}
-
-		if(digits < 10) {	//targeted value is in index 8
-			if((_decLoc[8]) - 48 != count) {	//if the current decimal places doesn't match the new number's
-				_decLoc[8] = (count) + 48;	//change the decimal places on the sign
-			}
-		}
-		else {	//targeted value is in index 9
-			if((_decLoc[9]) - 48 != count) {
-				_decLoc[9] = (count) + 48;
-			}
+	if(editBounds && VMDisplay::setArgument(decField, 2, count)) {	//option to account for changes in decimal places
+		VMDisplay::finishMessage();	//transfer the new command string into _commandData
+		if(!_queued) {	//in queued mode, poll sends it
+			VMDisplay::sendMessage();	//send _commandData to the display
 		}
-		VMDisplay::writeMessage(_commandString);	//transfer the new command string into _commandData
-		VMDisplay::sendMessage();	//send _commandData to the display
 	}
 
-	VMDisplay::updateDecimal(variable + 1, result, editBounds);	//send the shifted value to the int overload of this function
+	VMDisplay::writeDecimal(variable + 1, result, editBounds);	//send the shifted value the same way as the int overload
+	VMDisplay::updateWidgets(variable + 1, actual);
 }
 
 /*******************************************************************************
@@ -292,7 +529,8 @@ Description: Update one of the display's stored decimal variables. This overload
 			 is meant to be used with integer values (whole numbers). This
 			 function will adjust the digit length automatically unless otherwise
 			 specified. If bounds are adjusted, the message is rewritten to the
-			 sign, resetting its position to start.
+			 sign, resetting its position to start. Bars, thresholds, and alarms
+			 built to follow the variable are updated too.
 
 Parameters: -int variable - Specifies which of the display's 32 decimal variables
 			 you are updating.
@@ -304,9 +542,15 @@ Returns: 	-None
 Example Code:
 *******************************************************************************/
 void VMDisplay::updateDecimal(int variable, long int number, bool editBounds) {
+	VMDisplay::checkAlarms(variable, number);	//so a bounds adjustment already shows the new alarms
+	VMDisplay::writeDecimal(variable, number, editBounds);
+	VMDisplay::updateWidgets(variable, number);
+}
+
+void VMDisplay::writeDecimal(int variable, long int number, bool editBounds) {
 	variable -= 1;	//subtract one because the variable is zero addressed
-	_decLoc = strstr(_commandString, "DEC");
-	if(strstr(_commandString, "DEC") == NULL) {
+	char *decField = VMDisplay::findField("DEC", variable + 1);
+	if(decField == NULL) {
 		editBounds = false;
 	}
 	if(editBounds) {	//option to account for changes in total digits
@@ -316,44 +560,18 @@ void VMDisplay::updateDecimal(int variable, long int number, bool editBounds) {
 			temporary /= 10;
 			digits++;
 		}
-		if(!digits) {	//a syntax error is displayed if 0 is set for digits
-			editBounds = false;	//do not edit bounds
-		}
-		//conditions for if the decimal bounds need to be shifted
-		if((digits < 10 && (_decLoc[6] - 48 != digits || _decLoc[7] != ' ')) || (digits > 9 && _decLoc[7] != 48 + (digits - (10 * (digits / 10))))) {
-			if(digits < 10) {	//one number needs to be changed
-				_decLoc[6] = 48 + digits;	//set current digits to the amount in the number
-				if(_decLoc[7] != ' ') {	//check if the number of digits was greater than 9 previously
-					char temp[256];	//array to contain all characters after the number that was written
-					for(int i = 0; i < strlen(_decLoc); i++) {	//shift the data after what was written to the left
-						temp[i] = _decLoc[8 + i];
-					}
-					for(int i = 0; i < strlen(_decLoc) - 7; i++) {
-						_decLoc[7 + i] = temp[i];
-					}
-				}
-			}
-			else {	//if the digits are 10 or 11 (>11 is not allowed)
-				if(!(strlen(_decLoc) < 0)) {
-					char temp[256];
-					int places = digits;
-					for(int i = 0; i < strlen(_decLoc); i++) {
-						temp[i] = _decLoc[7 + i];
-					}
-					_decLoc[6] = 48 + (digits / 10);	//write 10s digit
-					_decLoc[7] = 48 + (digits - (10 * (digits / 10)));	//write 1s digit
-					for(int i = 0; i < strlen(_decLoc) - 7; i++) {	//shift data after written data to the right
-						_decLoc[8 + i] = temp[i];
-					}
-				}
+		//a syntax error is displayed if 0 is set for digits
+		if(digits && VMDisplay::setArgument(decField, 1, digits)) {
+			VMDisplay::finishMessage();	//transfer the new command string into _commandData
+			if(!_queued) {
+				VMDisplay::sendMessage();	//send _commandData to the display
 			}
-			VMDisplay::writeMessage(_commandString);	//transfer the new command string into _commandData
-			VMDisplay::sendMessage();	//send _commandData to the display
 		}
 	}
-	VMDisplay::connect();	//ensure connection to the correct display
-	VMClient.holdingRegisterWrite(100 + (variable * 2), number & 0xFFFF);	//write high byte into variable's register
-	VMClient.holdingRegisterWrite(99 + (variable * 2), (number >> 16) & 0xFFFF);	//write low byte into variable's register
+	uint16_t words[2];
+	words[0] = (number >> 16) & 0xFFFF;	//high word goes in the variable's first register
+	words[1] = number & 0xFFFF;	//low word goes in the variable's second register
+	VMDisplay::writeVariable(99 + (variable * 2), words, 2);	//write both in one transaction so the value can't tear
 }
 
 /*******************************************************************************
@@ -364,8 +582,9 @@ Description: Update one of the display's stored string variables. This
 
 Parameters: -int variable - Specifies which of the display's 16 string variables
 			 you are updating.
-			-const char text[] - Enter a string literal of up to 100 characters to
-			 update the variable with.
+			-const char text[] - Enter a UTF-8 string literal of up to 100
+			 characters to update the variable with. Characters are replaced the
+			 same way as setText.
 			-bool editBounds - Enable or disable bound adjustments (enabled defaultly).
 
 Returns: 	-None
@@ -373,457 +592,2628 @@ Returns: 	-None
 Example Code:
 *******************************************************************************/
 void VMDisplay::updateStringVar(int variable, const char text[100], bool editBounds) {
-	variable -= 1;	//subtract one because the variable is zero addressed
-	_strLoc = strstr(_commandString, "STR");	//find location of DEC in the current command string
-	if(strstr(_commandString, "STR") == NULL) {	//if the command string doesn't contain STR
-		editBounds = false;						//do not edit bounds
-	}
-	int chars = strlen(text);	//total characters in text to write
-	uint16_t temp[50];	//array of data to write
-	memset(temp, 0, 50);	//clear array
-	int tempPos = 0;	//index tracker in temp
-	if(editBounds) {	//option to account for changes in character length
-		if((chars < 10 && (_strLoc[6] - 48 != chars || _strLoc[7] != '>')) || (chars > 9 && _strLoc[7] != 48 + (chars - (10 * (chars / 10))))) {
-			//conditions for if the character bounds need to be shifted
-			if(chars < 10) {	//check if one char needs to be rewritten
-				_strLoc[6] = 48 + chars;	//write char count
-				while(_strLoc[7] != '>') {	//shift left until end of field is found
-					char temp[256];
-					for(int i = 0; i < strlen(_strLoc); i++) {
-						temp[i] = _strLoc[8 + i];
-					}
-					for(int i = 0; i < strlen(_strLoc) - 7; i++) {
-						_strLoc[7 + i] = temp[i];
-					}
-				}
-			}
-			else if(chars < 100) {	//check if two characters needs to be rewritten
-				if(!(strlen(_strLoc) < 0)) {
-					char temp[256];
-					for(int i = 0; i < strlen(_strLoc); i++) {	//store data past digit to be written
-						temp[i] = _strLoc[7 + i];
-					}
-					_strLoc[6] = 48 + (chars / 10);	//write char count 10s digit
-					_strLoc[7] = 48 + (chars - (10 * (chars / 10))); //write char count 1s digit
-					for(int i = 0; i < strlen(_strLoc) - 7; i++) {	//rewrite data to the right of what's been written
-						_strLoc[8 + i] = temp[i];
-					}
-				}
-			}
-			else if(chars == 100) {	//check if three characters needs to be rewritten (only 100 chars are allowed)
-				if(!(strlen(_strLoc) < 0)) {
-					char temp[256];
-					for(int i = 0; i < strlen(_strLoc); i++) {	//store data past digit to be written
-						temp[i] = _strLoc[7 + i];
-					}
-					_strLoc[6] = 49;	//write a 1
-					_strLoc[7] = 48;	//write a 0
-					_strLoc[8] = 48;	//write a 0
-					for(int i = 0; i < strlen(_strLoc) - 7; i++) {	//rewrite data to the right of what's been written
-						_strLoc[9 + i] = temp[i];
+	uint16_t *registers = VMDisplay::stringRegisters();
+	int chars = packText(registers, 0, text);	//only 100 characters are allowed
+	VMDisplay::writeStringVar(variable, registers, chars, editBounds);
+}
+
+/*******************************************************************************
+Description: Update one of the display's stored string variables with a formatted
+			 number, without sprintf. The number is written straight into the
+			 string variable's registers, right to left, two digits at a time.
+			 Bounds are adjusted the same way as updateStringVar.
+
+Parameters: -int variable - Specifies which of the display's 16 string variables
+			 you are updating.
+			-long int number - The number, scaled by 10 for every decimal place
+			 in the format (1234 with 2 decimals shows 12.34).
+			-const VMFormat &format - How to show the number.
+			-bool editBounds - Enable or disable bound adjustments (enabled defaultly).
+
+Returns: 	-None
+
+Example Code:
+	VMFormat flow;
+	flow.decimals = 1;
+	flow.separator = ',';
+	flow.suffix = " l/min";
+	sign.formatStringVar(1, 123456L, flow);	//12,345.6 l/min
+*******************************************************************************/
+void VMDisplay::formatStringVar(int variable, long int number, const VMFormat &format, bool editBounds) {
+	int decimals = format.decimals;
+	if(decimals > 9) {
+		Serial.println("Format can have at most 9 decimals.");
+		return;
+	}
+	unsigned long magnitude = (number < 0) ? 0UL - (unsigned long)number : (unsigned long)number;
+	int digits = 1;
+	for(unsigned long power = 1; magnitude / 10 >= power; power *= 10) {	//one division, and power can't overflow
+		digits++;
+	}
+	if(digits < decimals + 1) {	//always a digit in front of the point
+		digits = decimals + 1;
+	}
+	int point = decimals ? 1 : 0;
+	int separators = format.separator ? (digits - decimals - 1) / 3 : 0;
+	char sign = (number < 0) ? '-' : (format.showSign ? '+' : 0);
+	int length = digits + point + separators + (sign ? 1 : 0);
+	int padding = (format.width > length) ? format.width - length : 0;
+	if(length + padding > 100) {
+		Serial.println("Formatted number is longer than 100 characters.");
+		return;
+	}
+	uint16_t *registers = VMDisplay::stringRegisters();
+	int chars = 0;
+	bool zeros = format.pad == '0';	//zeros go between the sign and the number
+	for(int i = 0; !zeros && i < padding; i++) {
+		packChar(registers, chars++, format.pad);
+	}
+	if(sign) {
+		packChar(registers, chars++, sign);
+	}
+	for(int i = 0; zeros && i < padding; i++) {
+		packChar(registers, chars++, '0');
+	}
+	int last = chars + digits + point + separators - 1;	//index of the number's last character
+	if(point) {
+		packChar(registers, last - decimals, '.');
+	}
+	for(int k = 0; k < digits; k += 2) {	//two digits per division
+		int pair = (magnitude % 100) * 2;
+		magnitude /= 100;
+		for(int j = 0; j < 2 && k + j < digits; j++) {
+			int digit = k + j;	//digits from the right
+			int offset = digit;
+			if(digit >= decimals) {	//integer digits are past the point and any separators
+				offset += point;
+				if(format.separator) {
+					offset += (digit - decimals) / 3;
+					if((digit - decimals) % 3 == 0 && digit != decimals) {
+						packChar(registers, last - offset + 1, format.separator);
 					}
 				}
 			}
-			VMDisplay::writeMessage(_commandString);	//transfer the new command string into _commandData
-			VMDisplay::sendMessage();	//send _commandData to the display
-		}
-	}
-	for(int i = 0; i < chars; i += 2) { //iterate and combine each two characters in an index of temp
-		if(i + 1 > chars - 1) {
-			temp[tempPos] = (uint16_t)(text[i]);
-			tempPos++;
-			break;
-		}
-		else {
-			temp[tempPos] = ((uint16_t)(text[i + 1]) * 256) + (uint16_t)(text[i]);
-		}
-		tempPos++;
-	}
-	for(int i = 0; i < (sizeof(temp) / sizeof(uint16_t)); i++) {	//clear extra indexes
-		if(i > tempPos) {
-			temp[i] = 0;
+			packChar(registers, last - offset, pgm_read_byte(&digitPairs[pair + 1 - j]));
 		}
 	}
-	VMDisplay::connect();	//ensure connection to the correct display
-	VMClient.beginTransmission(HOLDING_REGISTERS, 199 + (variable * 50), 50);	//write string to display's registers
-	for (int i = 0; i < 50; i++) {
-		VMClient.write(temp[i]);
+	chars = last + 1;
+	if(format.suffix != NULL) {
+		chars = packText(registers, chars, format.suffix);
 	}
-	VMClient.endTransmission();
+	VMDisplay::writeStringVar(variable, registers, chars, editBounds);
 }
 
 /*******************************************************************************
-Description: Write characters at the end of a char array passed to the function. The
-			 function returns how many characters it has written after completing.
+Description: Update one of the display's stored string variables with a formatted
+			 number, rounded to the format's decimals.
 
-Parameters: -int startPos - The array index to start writing entered characters.
-			-const char text[] - Enter a string literal to be written into the array.
-			-char *arr - A pointer to the char array you are writing the characters to.
+Parameters: -int variable - Specifies which of the display's 16 string variables
+			 you are updating.
+			-double number - The number to show.
+			-const VMFormat &format - How to show the number.
+			-bool editBounds - Enable or disable bound adjustments (enabled defaultly).
 
-Returns: 	-Number of characters written to the char array.
+Returns: 	-None
 
 Example Code:
+	sign.formatStringVar(1, 12345.6, flow);
 *******************************************************************************/
-int VMDisplay::writeToArr(int startPos, const char text[], char *arr) {
-	int charsWritten = 0;	//counter for characters written
-	for(int i = startPos; i < startPos + strlen(text); i++) {
-		arr[i] = text[i - startPos];	//write new char at the end of the array
-		charsWritten++;	//increment counter
+void VMDisplay::formatStringVar(int variable, double number, const VMFormat &format, bool editBounds) {
+	for(int i = 0; i < format.decimals && i < 9; i++) {
+		number *= 10;
 	}
-	return charsWritten;
+	VMDisplay::formatStringVar(variable, (long int)((number < 0) ? number - 0.5 : number + 0.5), format, editBounds);
 }
 
 /*******************************************************************************
-Description: Configure the ASCII array with data concerning the custom settings
-			 of each enabled line.
+Description: Clears the registers string variables are packed into. They belong
+			 to the task updating variables, so the remembered registers are only
+			 updated once the write is made (see rememberRegisters).
 
-Parameters: -int startPos - The array index to begin appending line-specific
-			 characters to.
-			-int lineSelected - The line that contains the data being used to
-			 write the information.
-			-char *arr A pointer to the char array you are writing line-specific
-			 data to.
+Parameters: -None
 
-Returns: 	-The amount of characters written to the pointed array.
+Returns: 	-50 cleared registers.
 
 Example Code:
 *******************************************************************************/
-int VMDisplay::lineConfig(int startPos, int lineSelected, char *arr) {
-	int pos = startPos;
-	bool colorRetained;
-	bool winRetained;
-	int linesClearBelow = 0;
-	int clearPixels = 0;
-	const int lineHeight = lineSelected * 8;
-	if(lineSelected != 0) {	//if the line above has the same color or scrollType, data can be retained
-		colorRetained = (line[lineSelected].color == line[lineSelected - 1].color) && line[lineSelected - 1].isEnabled;
-		winRetained = (line[lineSelected].scrollType == line[lineSelected - 1].scrollType) && line[lineSelected - 1].isEnabled;
-	}
-	else {	//line 1 (specified by 0) retains nothing
-		colorRetained = false;
-		winRetained = false;
-	}
-	for(int i = 1; i < (4 - lineSelected); i++) {	//increment lines clear below for every disabled or scroll-matching line below
-		if((line[lineSelected].scrollType == line[lineSelected + i].scrollType) || !line[lineSelected + i].isEnabled) {
-			linesClearBelow++;
-		}
-		else {
-			break;	//leave loop as soon as a non-clear line is found
-		}
-	}
-	clearPixels = (lineHeight + 8 + (linesClearBelow * 8)) - 1;	//pixels to be specified for window height
-	if(!winRetained) {	//is the line's window hasn't been retained
-		pos +=	writeToArr(pos, "<WIN 0 ", arr);	//write "<WIN 0 " at end of array
-		if(lineSelected < 2) {	//single digit line height check
-			arr[pos] = 48 + lineHeight;	//write digit at end of array
-			pos++;	//increment pos
-		}
-		else {	//two digit line height
-			arr[pos] = 48 + (lineHeight / 10);	//write 10s digit
-			pos++;
-			arr[pos] = lineHeight - ((lineHeight / 10) * 10) + 48;	//write 1s digit
-			pos++;
-		}
-		pos +=	writeToArr(pos, " 287 ", arr);	//write window width of max
-		arr[pos] = 48 + (clearPixels / 10);	//write window height
-		pos++;
-		arr[pos] = clearPixels - ((clearPixels / 10) * 10) + 48;
-		pos++;
-		pos += writeToArr(pos, ">", arr);
-	}
-
-	pos += writeToArr(pos, "<POS 0 ", arr);	//line starting position
-	if(lineSelected < 2) {
-			arr[pos] = 48 + lineHeight;
-			pos++;
-		}
-	else {
-		arr[pos] = 48 + (lineHeight / 10);
-		pos++;
-		arr[pos] = lineHeight - ((lineHeight / 10) * 10) + 48;
-		pos++;
-	}
-	pos += writeToArr(pos, ">", arr);	//close field
+uint16_t *VMDisplay::stringRegisters() {
+	memset(_scratch, 0, sizeof(_scratch));
+	return _scratch;
+}
 
-	if(!winRetained || (line[lineSelected].scrollType >= 4 && line[lineSelected].scrollType <= 6)) {	//window being retained also means scroll is retained
-		switch(line[lineSelected].scrollType) {	//use default scroll type or type defined by user
-			case 0:
-				pos += writeToArr(pos, "<SL>", arr);
-				break;
-			case 1:
-				pos += writeToArr(pos, "<SR>", arr);
-				break;
-			case 2:
-				pos += writeToArr(pos, "<SU>", arr);
-				break;
-			case 3:
-				pos += writeToArr(pos, "<SD>", arr);
-				break;
-			case 4:
-				pos += writeToArr(pos, "<LJ>", arr);
-				break;
-			case 5:
-				pos += writeToArr(pos, "<CJ>", arr);
-				break;
-			case 6:
-				pos += writeToArr(pos, "<RJ>", arr);
-				break;
-		}
-		if(line[lineSelected].scrollType < 4) {		//if the line is set to scroll
-			pos += writeToArr(pos, "<S ", arr);	//write its scroll speed as defined
-			if(line[lineSelected].scrollSpeed == 0) {
-				pos += writeToArr(pos, "S>", arr);
-			}
-			else if(line[lineSelected].scrollSpeed == 1) {
-				pos += writeToArr(pos, "M>", arr);
-			}
-			else if(line[lineSelected].scrollSpeed == 2) {
-				pos += writeToArr(pos, "F>", arr);
-			}
-		}
-	}
+/*******************************************************************************
+Description: Writes a packed string variable to the display, first adjusting the
+			 bounds of its field to the amount of characters if enabled.
 
-	pos += writeToArr(pos, "<BL ", arr);	//write blink speed (if any)
-	switch(line[lineSelected].blink) {	//use variable defined defaultly or by user
-		case 0:
-			pos += writeToArr(pos, "S>", arr);
-			break;
-		case 1:
-			pos += writeToArr(pos, "M>", arr);
-			break;
-		case 2:
-			pos += writeToArr(pos, "F>", arr);
-			break;
-		case 3:
-			pos += writeToArr(pos, "N>", arr);
-			break;
-	}
+Parameters: -int variable - The string variable, from 1.
+			-const uint16_t *registers - Its packed registers.
+			-int chars - Characters packed.
+			-bool editBounds - Enable or disable bound adjustments.
 
-	pos += writeToArr(pos, "<CS ", arr);	//write text size (Character Set)
-	if(line[lineSelected].textSize > 9) {	//two digit size
-		arr[pos] = 48 + (line[lineSelected].textSize / 10);
-		pos++;
-		arr[pos] = line[lineSelected].textSize - ((line[lineSelected].textSize / 10) * 10) + 48;
-		pos++;
-	}
-	else {	//one digit size
-		arr[pos] = 48 + line[lineSelected].textSize;
-		pos++;
-	}
-	pos += writeToArr(pos, ">", arr);
+Returns: 	-None
 
-	if(!colorRetained) {	//if color wasn't retained
-		if(line[lineSelected].color == 0) {	//use variable defined defaultly or by user
-			pos += writeToArr(pos, "<GRN>", arr);
-		}
-		else if(line[lineSelected].color == 1) {
-			pos += writeToArr(pos, "<RED>", arr);
-		}
-		else if(line[lineSelected].color == 2) {
-			pos += writeToArr(pos, "<AMB>", arr);
+Example Code:
+*******************************************************************************/
+void VMDisplay::writeStringVar(int variable, const uint16_t *registers, int chars, bool editBounds) {
+	variable -= 1;	//subtract one because the variable is zero addressed
+	char *strField = VMDisplay::findField("STR", variable + 1);	//find this variable's field in the current command string
+	//option to account for changes in character length
+	if(editBounds && strField != NULL && chars && VMDisplay::setArgument(strField, 1, chars)) {
+		VMDisplay::finishMessage();	//transfer the new command string into _commandData
+		if(!_queued) {
+			VMDisplay::sendMessage();	//send _commandData to the display
 		}
 	}
-
-	pos += writeToArr(pos, "<T>", arr);	//open text field
-	pos += writeToArr(pos, line[lineSelected].text, arr);	//write user-defined text (defaultly "")
-	pos += writeToArr(pos, "</T>", arr);	//close text field
-
-	pos-= 11;
-
-	return pos;
+	VMDisplay::writeVariable(199 + (variable * 50), registers, 50);	//write string to display's registers
 }
 
 /*******************************************************************************
-Description: Uses data stored in the object's members (and the line's members)
-			 to fill the char array pointed to with the command message.
+Description: Brings every widget following a decimal variable up to date with its
+			 new value. A bar only writes the registers of the cells that changed.
+			 A threshold only rewrites the message when its color changes, by
+			 replacing the color field in front of the field it colors.
 
-Parameters: -char *string - A pointer to the char array to be loaded with the
-			 ASCII command message.
+Parameters: -int variable - The decimal variable that changed.
+			-double value - Its new value.
 
-Returns: 	-The amount of characters written to the specified array.
+Returns: 	-None
 
 Example Code:
 *******************************************************************************/
-int VMDisplay::generateString(char *string) {
-	char temp[512];	//temp array to contain the command string
-	memset(temp, 0x00, 512);	//clear array
-	int tempPos = 0;	//counter for array position
-
-	tempPos += VMDisplay::writeToArr(tempPos, "<ID ", temp);	//start ID field
-	if(_ID > 99) {	//three chars need to be written
-		temp[tempPos] = 48 + (_ID / 100);
-		tempPos++;
-		temp[tempPos] = 48 + (_ID - ((_ID / 100) * 100)) / 10;
-		tempPos++;
-		temp[tempPos] = 48 + (_ID - ((_ID / 10) * 10));
-		tempPos++;
-	}
-	else if(_ID > 9) {	//two chars need to be written
-		temp[tempPos] = 48 + (_ID / 10);
-		tempPos++;
-		temp[tempPos] = 48 + (_ID - (10 * (_ID / 10)));
-		tempPos++;
-	}
-	else {	//one char needs to be written
-		temp[tempPos] = 48 + _ID;
-		tempPos++;
-	}
-	tempPos += VMDisplay::writeToArr(tempPos, "><CLR>", temp);	//write clear field
-	if(_maintenanceCommand != 4) {	//a maintenance command being set will overwrite any lines defined
-		tempPos += VMDisplay::writeToArr(tempPos, "<MTN ", temp);
-		temp[tempPos] = 48 + _maintenanceCommand;
-		tempPos++;
-		tempPos += VMDisplay::writeToArr(tempPos, ">", temp);
-	}
-	else {	//no maintenance command has been set
-		for(int i = 0; i < 4; i++) {	//pass temp to lineConfig for each line enabled
-			if(line[i].isEnabled) {
-				tempPos += VMDisplay::lineConfig(tempPos, i, temp);
+void VMDisplay::updateWidgets(int variable, double value) {
+	bool rewrite = false;
+	for(int i = 0; i < _widgetCount; i++) {
+		Widget &widget = _widgets[i];
+		if(widget.variable != variable) {
+			continue;
+		}
+		if(widget.type == WIDGET_BAR) {
+			double fraction = (value - widget.minimum) / (double)(widget.maximum - widget.minimum);
+			int lit = (fraction <= 0) ? 0 : (fraction >= 1) ? widget.size : (int)(fraction * widget.size);
+			if(lit == widget.state) {	//nothing to write
+				continue;
+			}
+			int first = 0;	//cells that change
+			int last = widget.size - 1;
+			if(widget.state >= 0) {
+				first = (lit < widget.state) ? lit : widget.state;
+				last = ((lit > widget.state) ? lit : widget.state) - 1;
+			}
+			widget.state = lit;
+			int string = widget.field - 1;
+			uint16_t *registers = VMDisplay::stringRegisters();
+			for(int cell = 0; cell < widget.size; cell++) {	//lit cells hold the fill glyph, the rest are blank
+				packChar(registers, cell, (cell < lit) ? _fillGlyph : ' ');
+			}
+			VMDisplay::writeVariable(199 + (string * 50) + (first / 2), &registers[first / 2], (last / 2) - (first / 2) + 1);
+		}
+		else if(widget.type == WIDGET_THRESHOLD && widget.field) {
+			int color = widget.colors[value >= widget.minimum];
+			if(color == widget.state) {
+				continue;
+			}
+			char *field = VMDisplay::findField(widget.size ? "STR" : "DEC", widget.field);
+			if(field == NULL) {	//the message doesn't show the field anymore
+				continue;
+			}
+			char *after = strchr(field, '>') + 1;
+			if(*after && !isColorTag(after)) {	//put the below color back after the field so text following it doesn't change
+				int tail = strlen(after);
+				if((after - _commandString) + tail + 10 > VM_MAX_COMMAND - 1) {	//room for this and the color in front
+					Serial.println("Command string is full, threshold color was not changed.");
+					continue;
+				}
+				memmove(after + 5, after, tail + 1);
+				after[0] = '<';
+				memcpy(after + 1, colorNames[widget.colors[0]], 3);
+				after[4] = '>';
+			}
+			if(field - _commandString >= 6 && field[-1] == '>') {	//a bar's character set sits between its color and field
+				char *previous = field - 2;
+				while(previous > _commandString && *previous != '<') {
+					previous--;
+				}
+				if(!strncmp(previous, "<CS ", 4)) {
+					field = previous;
+				}
+			}
+			if(field - _commandString >= 5 && isColorTag(field - 5)) {
+				memcpy(field - 4, colorNames[color], 3);	//replace the color in front of the field
+			}
+			else {	//the color was left out when the message was minimized, so put one back
+				int tail = strlen(field);
+				if((field - _commandString) + tail + 5 > VM_MAX_COMMAND - 1) {
+					Serial.println("Command string is full, threshold color was not changed.");
+					continue;
+				}
+				memmove(field + 5, field, tail + 1);
+				field[0] = '<';
+				memcpy(field + 1, colorNames[color], 3);
+				field[4] = '>';
 			}
+			widget.state = color;
+			rewrite = true;
 		}
 	}
-	int stringPos = 0;	//position of array being passed into the function
-	memset(_commandString, 0, 512);
-	for(int i = 0; i < 511; i++) {	//write every char > 0x19 into the string passed in
-		if(temp[i] > 0x19) {
-			string[stringPos] = temp[i];
-			_commandString[stringPos] = temp[i];
-			stringPos++;
+	if(rewrite) {	//one message for every threshold that changed, packed with the current alarms
+		VMDisplay::finishMessage();
+		if(!_queued) {
+			VMDisplay::sendMessage();
 		}
 	}
-
-	return tempPos;
+	else if(_alarmed != _frontAlarmed) {
+		VMDisplay::switchAlarms(_alarmed);
+	}
 }
 
 /*******************************************************************************
-Description: After the generateString function fills the char array with ASCII
-			 data for the display, this function prepares it to be written through
-			 modbus by flipping each two characters and putting them into a single
-			 uint16_t contained in the _commandData array. This overload is called
-			 with no parameters, and uses data previously specified using the
-			 line-specific commands.
+Description: Turns the alarms following a decimal variable on or off for its new
+			 value. An alarm turns on at its limit and only turns off once the
+			 value is past its clear level. The message shown is switched later
+			 by updateWidgets, or sooner if the bounds are adjusted.
 
-Parameters: -None
+Parameters: -int variable - The decimal variable that changed.
+			-double value - Its new value.
 
 Returns: 	-None
 
 Example Code:
 *******************************************************************************/
-void VMDisplay::writeMessage() {
-	uint16_t temp[512];	//array containing data to be sent through modbus
-	int tempPos = 0;	//counter for temp's position
-	char text[512];	//array containing the command string
-	memset(text, 0, 512);	//clear text
-	memset(temp, 0, 512);	//clear temp
-	memset(_commandData, 0, 512);	//clear message
-	VMDisplay::generateString(text);	//write command string into text
-	bool endedOdd = false;	//flag when every char cannot be paired evenly
-	char terminate[] = { 0x0D, 0x0D, 0xCC };	//end carriage chars
-	_completed = false;	//flag the message as not being sent
-	for(int i = 0; i < strlen(text); i += 2) {	//pair each two chars together and add them to temp
-		if(i + 1 > strlen(text) - 1) {	//if the program is going to reach out of bounds
-			//set endedOdd to true, and write the all three end carriage chars with the last text char
-			temp[tempPos] = ((uint16_t)(terminate[0]) * 256) + (uint16_t)(text[i]);
-			temp[tempPos + 1] = ((uint16_t)(terminate[2]) * 256) + (uint16_t)(terminate[1]);
-			tempPos += 2;
-			endedOdd = true;
-			break;
+void VMDisplay::checkAlarms(int variable, double value) {
+	for(int i = 0; i < _widgetCount; i++) {
+		Widget &widget = _widgets[i];
+		if(widget.type != WIDGET_ALARM || widget.variable != variable || !widget.field) {
+			continue;
 		}
-		else {	//pair and write normally
-			temp[tempPos] = ((uint16_t)(text[i + 1]) * 256) + (uint16_t)(text[i]);
-			tempPos++;
+		bool high = widget.minimum >= widget.maximum;	//alarms on high values if the limit is above the clear level
+		bool on = widget.state ? (high ? value > widget.maximum : value < widget.maximum)
+							   : (high ? value >= widget.minimum : value <= widget.minimum);
+		widget.state = on;
+		if(on) {
+			_alarmed |= (1UL << i);
 		}
-	}
-	if(!endedOdd) {	//after ending even, write the first two end carriage chars
-		temp[tempPos] = ((uint16_t)(terminate[1]) * 256) + (uint16_t)(terminate[0]);
-		tempPos++;
-	}
-	for(int i = 0; i < (sizeof(temp) / sizeof(uint16_t)); i++) {
-		if(i > tempPos) {	//clear any unused indexes
-			temp[i] = 0;
+		else {
+			_alarmed &= ~(1UL << i);
 		}
-		_commandData[i] = temp[i];	//write temp into _commandData
 	}
-	messageLength = tempPos;	//set messageLength to tempPos
 }
 
 /*******************************************************************************
-Description: This function prepares the data passed to be written through modbus
-			 by flipping each two characters and putting them into a single
-			 uint16_t contained in the _commandData array. This overload is run by
-			 passing the entire command string in as a string literal. This is intended
+Description: Publishes the message with a new set of alarms. With VM_ALARM_BUFFER,
+			 switching between normal and every alarm uses the variant packed with
+			 the message, so the buffers are only swapped. Otherwise the new set of
+			 alarms is packed here.
+
+Parameters: -uint32_t alarmed - A bit set for each widget that is alarmed.
+
+Returns: 	-None
+
+Example Code:
+*******************************************************************************/
+void VMDisplay::switchAlarms(uint32_t alarmed) {
+	_alarmed = alarmed;
+	if(_alternate >= 0 && alarmed == _alternateAlarmed) {	//swap in the precomputed variant
+		int previous = __atomic_load_n(&_front, __ATOMIC_SEQ_CST);
+		uint32_t previousAlarmed = _frontAlarmed;
+		VMDisplay::publishMessage(_alternate, _length[_alternate]);
+		_frontAlarmed = alarmed;
+		_alternate = previous;	//keep the message that was shown to swap back to
+		_alternateAlarmed = previousAlarmed;
+	}
+	else {
+		int back = VMDisplay::backBuffer();
+		int length = VMDisplay::packVariant(back, alarmed);
+		if(length < 0) {
+			return;
+		}
+		VMDisplay::publishMessage(back, length);
+		_frontAlarmed = alarmed;
+	}
+	if(!_queued) {	//in queued mode, poll sends it
+		VMDisplay::sendMessage();
+	}
+}
+
+uint32_t VMDisplay::alarmMask() {
+	uint32_t all = 0;
+	for(int i = 0; i < _widgetCount; i++) {
+		if(_widgets[i].type == WIDGET_ALARM && _widgets[i].field) {
+			all |= (1UL << i);
+		}
+	}
+	return all;
+}
+
+/*******************************************************************************
+Description: Finds a variable's field in the command string, like <DEC 3 5 0> for
+			 decimal variable 3.
+
+Parameters: -const char name[] - The field's name, "DEC" or "STR".
+			-int variable - The variable number the field shows.
+
+Returns: 	-A pointer to the field's opening '<', or NULL if it isn't found.
+
+Example Code:
+*******************************************************************************/
+char *VMDisplay::findField(const char name[], int variable) {
+	int length = strlen(name);
+	for(char *field = strchr(_commandString, '<'); field != NULL; field = strchr(field + 1, '<')) {
+		if(!strncmp(field + 1, name, length) && field[1 + length] == ' ' && atol(field + 1 + length) == variable) {
+			return field;
+		}
+	}
+	return NULL;
+}
+
+/*******************************************************************************
+Description: Replaces one of a field's arguments in the command string with a
+			 number. The rest of the command string is moved in place to fit the
+			 new amount of digits, so no copy of it is needed.
+
+Parameters: -char *field - A pointer to the field's opening '<'.
+			-int argument - Which argument to replace, 0 being the first.
+			-long int value - The number to write.
+
+Returns: 	-True if the argument was changed, false if it already held the
+			 value or the command string would overflow.
+
+Example Code:
+*******************************************************************************/
+bool VMDisplay::setArgument(char *field, int argument, long int value) {
+	char *arg = field;
+	for(int i = 0; i <= argument; i++) {	//skip to the start of the argument
+		arg = strchr(arg, ' ');
+		if(arg == NULL || arg > strchr(field, '>')) {
+			return false;
+		}
+		while(*arg == ' ') {
+			arg++;
+		}
+	}
+	int oldLength = strspn(arg, "0123456789");
+	char digits[11];
+	int newLength = 0;
+	do {	//write digits from least to most significant
+		digits[10 - newLength] = 48 + (value % 10);
+		newLength++;
+		value /= 10;
+	} while(value && newLength < 11);
+	if(oldLength == newLength && !strncmp(arg, &digits[11 - newLength], newLength)) {	//already holds the value
+		return false;
+	}
+	int tail = strlen(arg + oldLength);
+	if((arg - _commandString) + newLength + tail > VM_MAX_COMMAND - 1) {
+		Serial.println("Command string is full, bounds were not adjusted.");
+		return false;
+	}
+	memmove(arg + newLength, arg + oldLength, tail + 1);	//move the rest of the string, including its null
+	memcpy(arg, &digits[11 - newLength], newLength);
+	return true;
+}
+
+/*******************************************************************************
+Description: Write characters at the end of a char array passed to the function. The
+			 function returns how many characters it has written after completing.
+
+Parameters: -int startPos - The array index to start writing entered characters.
+			-const char text[] - Enter a string literal to be written into the array.
+			-char *arr - A pointer to the char array you are writing the characters to.
+
+Returns: 	-Number of characters written to the char array.
+
+Example Code:
+*******************************************************************************/
+int VMDisplay::writeToArr(int startPos, const char text[], char *arr) {
+	int charsWritten = 0;	//counter for characters written
+	for(int i = startPos; i < startPos + (int)strlen(text); i++) {
+		arr[i] = text[i - startPos];	//write new char at the end of the array
+		charsWritten++;	//increment counter
+	}
+	return charsWritten;
+}
+
+/*******************************************************************************
+Description: Appends characters to the end of the command string being built. If
+			 the command string is full, nothing more is written and the overflow
+			 flag is set so that the message is not sent truncated.
+
+Parameters: -const char text[] - The characters to append.
+
+Returns: 	-True if every character fit in the command string.
+
+Example Code:
+*******************************************************************************/
+bool VMDisplay::append(const char text[]) {
+	while(*text) {
+		if(!VMDisplay::append(*text)) {
+			return false;
+		}
+		text++;
+	}
+	return true;
+}
+
+bool VMDisplay::append(char c) {
+	if(_buildPos >= VM_MAX_COMMAND - 1) {	//leave room for the terminating null
+		_overflow = true;
+		return false;
+	}
+	if(_staging < 0) {	//no message is being built, or a send took its buffer
+		_overflow = true;
+		return false;
+	}
+	char *build = (char *)_commandData[_staging];
+	build[_buildPos] = c;
+	_buildPos++;
+	build[_buildPos] = 0;	//keep the message being built terminated
+	return true;
+}
+
+/*******************************************************************************
+Description: Appends a number to the end of the command string being built without
+			 any leading zeros.
+
+Parameters: -long int number - The number to append.
+
+Returns: 	-True if every digit fit in the command string.
+
+Example Code:
+*******************************************************************************/
+bool VMDisplay::appendNumber(long int number) {
+	char digits[11];	//enough for every digit of a 32 bit number
+	int count = 0;
+	if(number < 0) {
+		if(!VMDisplay::append('-')) {
+			return false;
+		}
+		number = -number;
+	}
+	do {	//write digits from least to most significant
+		digits[count] = 48 + (number % 10);
+		count++;
+		number /= 10;
+	} while(number && count < 11);
+	while(count) {	//then append them in reading order
+		count--;
+		if(!VMDisplay::append(digits[count])) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/*******************************************************************************
+Description: Set the size of the display in pixels. This is used by writeMessage
+			 to lay out the four lines and by anything else that needs to know the
+			 display's edges. The default is 288 x 32.
+
+Parameters: -int width - Width of the display in pixels.
+			-int height - Height of the display in pixels.
+
+Returns: 	-None
+
+Example Code:
+*******************************************************************************/
+void VMDisplay::setDisplaySize(int width, int height) {
+	_width = width;
+	_height = height;
+}
+
+/*******************************************************************************
+Description: Starts building a new command string. The display's ID and a clear
+			 field are written first, after which any of the builder functions
+			 (win, pos, scroll, blink, font, color, text, dec, str) can be called
+			 in the order they should appear in the message. Call endMessage to
+			 finish the message so it can be sent.
+
+Parameters: -None
+
+Returns: 	-None
+
+Example Code:
+	sign.beginMessage();
+	sign.win(0, 0, 287, 15);
+	sign.pos(0, 0);
+	sign.color(RED);
+	sign.text("Rate:");
+	sign.win(0, 16, 287, 31);
+	sign.pos(0, 16);
+	sign.dec(1, 5, 0);
+	sign.endMessage();
+*******************************************************************************/
+void VMDisplay::beginMessage() {
+	_buildPos = 0;
+	_overflow = false;
+	_buildWidgetCount = 0;	//widgets belong to the message they are built in
+	_pendingWidget = -1;
+	_staging = VMDisplay::backBuffer();	//built in a free message buffer so the written message stays intact
+	((char *)_commandData[_staging])[0] = 0;
+	VMDisplay::append("<ID ");
+	VMDisplay::appendNumber(_ID);
+	VMDisplay::append("><CLR>");
+}
+
+/*******************************************************************************
+Description: Appends a window field to the message being built. Everything after
+			 it is drawn inside this window until another window is opened.
+
+Parameters: -int x1, int y1 - Top left pixel of the window.
+			-int x2, int y2 - Bottom right pixel of the window.
+
+Returns: 	-None
+
+Example Code:
+*******************************************************************************/
+void VMDisplay::win(int x1, int y1, int x2, int y2) {
+	VMDisplay::append("<WIN ");
+	VMDisplay::appendNumber(x1);
+	VMDisplay::append(' ');
+	VMDisplay::appendNumber(y1);
+	VMDisplay::append(' ');
+	VMDisplay::appendNumber(x2);
+	VMDisplay::append(' ');
+	VMDisplay::appendNumber(y2);
+	VMDisplay::append('>');
+}
+
+/*******************************************************************************
+Description: Appends a position field to the message being built.
+
+Parameters: -int x, int y - Pixel where the following information starts.
+
+Returns: 	-None
+
+Example Code:
+*******************************************************************************/
+void VMDisplay::pos(int x, int y) {
+	VMDisplay::append("<POS ");
+	VMDisplay::appendNumber(x);
+	VMDisplay::append(' ');
+	VMDisplay::appendNumber(y);
+	VMDisplay::append('>');
+}
+
+/*******************************************************************************
+Description: Appends the scroll type or justification to the message being built.
+			 The scroll speed is only written if the type scrolls.
+
+Parameters: -int scrollType - Use constants SCROLL_LEFT, SCROLL_RIGHT, SCROLL_UP,
+			 SCROLL_DOWN, LEFT_JUSTIFIED, CENTER_JUSTIFIED, and RIGHT_JUSTIFIED.
+			-int scrollSpeed - Use constants SLOW, MEDIUM, and FAST.
+
+Returns: 	-None
+
+Example Code:
+*******************************************************************************/
+void VMDisplay::scroll(int scrollType, int scrollSpeed) {
+	switch(scrollType) {
+		case 0:
+			VMDisplay::append("<SL>");
+			break;
+		case 1:
+			VMDisplay::append("<SR>");
+			break;
+		case 2:
+			VMDisplay::append("<SU>");
+			break;
+		case 3:
+			VMDisplay::append("<SD>");
+			break;
+		case 4:
+			VMDisplay::append("<LJ>");
+			break;
+		case 5:
+			VMDisplay::append("<CJ>");
+			break;
+		case 6:
+			VMDisplay::append("<RJ>");
+			break;
+	}
+	if(scrollType < 4) {	//only scrolling types have a speed
+		switch(scrollSpeed) {
+			case 0:
+				VMDisplay::append("<S S>");
+				break;
+			case 1:
+				VMDisplay::append("<S M>");
+				break;
+			case 2:
+				VMDisplay::append("<S F>");
+				break;
+		}
+	}
+}
+
+/*******************************************************************************
+Description: Appends the blink speed to the message being built.
+
+Parameters: -int blink - Use constants SLOW, MEDIUM, FAST, and NONE.
+
+Returns: 	-None
+
+Example Code:
+*******************************************************************************/
+void VMDisplay::blink(int blink) {
+	switch(blink) {
+		case 0:
+			VMDisplay::append("<BL S>");
+			break;
+		case 1:
+			VMDisplay::append("<BL M>");
+			break;
+		case 2:
+			VMDisplay::append("<BL F>");
+			break;
+		case 3:
+			VMDisplay::append("<BL N>");
+			break;
+	}
+}
+
+/*******************************************************************************
+Description: Appends the text size to the message being built. Sizes are ordered
+			 0-11 from smallest to largest, the same as setTextSize.
+
+Parameters: -int textSize - The text size between 0-11.
+
+Returns: 	-None
+
+Example Code:
+*******************************************************************************/
+void VMDisplay::font(int textSize) {
+	VMDisplay::charSet(VMDisplay::charSetOf(textSize));
+}
+
+void VMDisplay::charSet(int charSet) {
+	VMDisplay::append("<CS ");
+	VMDisplay::appendNumber(charSet);
+	VMDisplay::append('>');
+}
+
+/*******************************************************************************
+Description: Converts an ordered text size (0-11) into the display's character
+			 set number, where 2 is the smallest followed by 0, 1, and 3-11.
+
+Parameters: -int textSize - The text size between 0-11.
+
+Returns: 	-The matching character set number.
+
+Example Code:
+*******************************************************************************/
+int VMDisplay::charSetOf(int textSize) {
+	if(textSize == 0) {		//2 is actually the smallest character set
+		return 2;
+	}
+	else if(textSize == 1) {
+		return 0;
+	}
+	else if(textSize == 2) {
+		return 1;
+	}
+	return textSize;	//anything other than 0, 1, and 2 are ordered normally
+}
+
+/*******************************************************************************
+Description: Appends the text color to the message being built.
+
+Parameters: -int color - Use constants RED, GREEN, and AMBER.
+
+Returns: 	-None
+
+Example Code:
+*******************************************************************************/
+void VMDisplay::color(int color) {
+	if(color == 0) {
+		VMDisplay::append("<GRN>");
+	}
+	else if(color == 1) {
+		VMDisplay::append("<RED>");
+	}
+	else if(color == 2) {
+		VMDisplay::append("<AMB>");
+	}
+}
+
+/*******************************************************************************
+Description: Appends a text field to the message being built. The text is UTF-8,
+			 and characters the display doesn't have are replaced the same way as
+			 setText. Control characters are left out since the display can't
+			 show them.
+
+Parameters: -const char text[] - The text to display.
+
+Returns: 	-None
+
+Example Code:
+*******************************************************************************/
+void VMDisplay::text(const char text[]) {
+	char glyphs[4];
+	VMDisplay::append("<T>");	//open text field
+	while(*text) {	//decode straight into the command string
+		int count = glyphsOf(decodeUTF8(&text), glyphs);
+		for(int i = 0; i < count; i++) {
+			VMDisplay::append(glyphs[i]);
+		}
+	}
+	VMDisplay::append("</T>");	//close text field
+}
+
+void VMDisplay::appendText(const char text[], int length) {	//text already in the display's characters
+	VMDisplay::append("<T>");	//open text field
+	for(int i = 0; i < length; i++) {
+		if((uint8_t)text[i] > 0x19) {
+			VMDisplay::append(text[i]);
+		}
+	}
+	VMDisplay::append("</T>");	//close text field
+}
+
+/*******************************************************************************
+Description: Checks that a row of the canvas holds exactly the run from x1 to x2
+			 in the given color, with neither neighbour in that color.
+
+Parameters: -VMCanvas &canvas - The canvas being checked.
+			-int x1, int x2 - First and last pixel of the run.
+			-int y - The row to check.
+			-int color - The color of the run.
+
+Returns: 	-true if the row holds the same run, false otherwise.
+
+Example Code:
+*******************************************************************************/
+static bool sameRun(VMCanvas &canvas, int x1, int x2, int y, int color) {
+	if(y < 0 || y >= VM_CANVAS_HEIGHT || canvas.getPixel(x1 - 1, y) == color || canvas.getPixel(x2 + 1, y) == color) {
+		return false;
+	}
+	for(int x = x1; x <= x2; x++) {
+		if(canvas.getPixel(x, y) != color) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/*******************************************************************************
+Description: Appends a canvas to the message being built. The display has no
+			 pixel fields, so lit pixels are joined into rectangles of one color
+			 and each rectangle is drawn as a window filled with the fill glyph,
+			 which the window clips to the rectangle's exact size. Off pixels
+			 aren't written since the message starts cleared. Once written, the
+			 canvas is marked clean so that only changed canvases need a new
+			 message.
+
+Parameters: -VMCanvas &canvas - The canvas to draw.
+
+Returns: 	-None
+
+Example Code:
+	sign.beginMessage();
+	sign.canvas(levels);
+	sign.endMessage();
+*******************************************************************************/
+void VMDisplay::canvas(VMCanvas &canvas) {
+	int written = -1;	//color written so far, -1 until written
+	VMDisplay::scroll(LEFT_JUSTIFIED);
+	VMDisplay::blink(NONE);
+	VMDisplay::charSet(_fillCharSet);
+	for(int y = 0; y < VM_CANVAS_HEIGHT; y++) {
+		int x = 0;
+		while(x < VM_CANVAS_WIDTH) {
+			int color = canvas.getPixel(x, y);
+			int end = x;
+			while(end + 1 < VM_CANVAS_WIDTH && canvas.getPixel(end + 1, y) == color) {	//find the end of this run
+				end++;
+			}
+			if(color != PIXEL_OFF && !sameRun(canvas, x, end, y - 1, color)) {	//runs continuing one above are already drawn
+				int bottom = y;
+				while(sameRun(canvas, x, end, bottom + 1, color)) {	//extend the rectangle down over identical runs
+					bottom++;
+				}
+				VMDisplay::win(x, y, end, bottom);	//text starts at the window's origin
+				if(color != written) {
+					VMDisplay::color(color);
+					written = color;
+				}
+				for(int top = y; top <= bottom; top += _fillHeight) {	//one row of glyphs per glyph height
+					if(top != y) {
+						VMDisplay::pos(x, top);
+					}
+					VMDisplay::append("<T>");
+					for(int i = x; i <= end; i += _fillWidth) {
+						VMDisplay::append(_fillGlyph);
+					}
+					VMDisplay::append("</T>");
+				}
+			}
+			x = end + 1;
+		}
+	}
+	if(!_overflow) {
+		canvas.markClean();
+	}
+}
+
+/*******************************************************************************
+Description: Sets the glyph canvas draws rectangles with. It should be lit across
+			 its whole width and height so that neighbouring glyphs join up. By
+			 default, character 0x7F of character set 0 is used as a 6 x 8 block.
+
+Parameters: -char glyph - The character to fill with.
+			-int charSet - The display's character set number for the glyph.
+			-int width - Pixels from one glyph to the next.
+			-int height - Pixels from one row of glyphs to the next.
+
+Returns: 	-None
+
+Example Code:
+	sign.setFillGlyph(0x7F, 0, 6, 8);
+*******************************************************************************/
+void VMDisplay::setFillGlyph(char glyph, int charSet, int width, int height) {
+	if(width < 1 || height < 1) {
+		Serial.println("Glyph width and height must be at least 1.");
+		return;
+	}
+	_fillGlyph = glyph;
+	_fillCharSet = charSet;
+	_fillWidth = width;
+	_fillHeight = height;
+}
+
+/*******************************************************************************
+Description: Appends one of the display's decimal variables to the message being
+			 built. Its value can then be changed with updateDecimal.
+
+Parameters: -int variable - Which of the display's 32 decimal variables to show.
+			-int digits - Total digits shown.
+			-int places - Digits shown after the decimal point.
+
+Returns: 	-None
+
+Example Code:
+*******************************************************************************/
+void VMDisplay::dec(int variable, int digits, int places) {
+	VMDisplay::bindWidget(variable, false);
+	VMDisplay::append("<DEC ");
+	VMDisplay::appendNumber(variable);
+	VMDisplay::append(' ');
+	VMDisplay::appendNumber(digits);
+	VMDisplay::append(' ');
+	VMDisplay::appendNumber(places);
+	VMDisplay::append('>');
+}
+
+/*******************************************************************************
+Description: Appends one of the display's string variables to the message being
+			 built. Its value can then be changed with updateStringVar.
+
+Parameters: -int variable - Which of the display's 16 string variables to show.
+			-int chars - Amount of characters shown.
+
+Returns: 	-None
+
+Example Code:
+*******************************************************************************/
+void VMDisplay::str(int variable, int chars) {
+	VMDisplay::bindWidget(variable, true);
+	VMDisplay::append("<STR ");
+	VMDisplay::appendNumber(variable);
+	VMDisplay::append(' ');
+	VMDisplay::appendNumber(chars);
+	VMDisplay::append('>');
+}
+
+/*******************************************************************************
+Description: Appends a horizontal bar to the message being built, drawn by a
+			 string variable filled with the fill glyph (see setFillGlyph). The bar
+			 follows a decimal variable, so every updateDecimal of that variable
+			 writes only the string registers of the cells that changed, and
+			 nothing at all if the bar didn't change. The fill glyph's character
+			 set is written in front of the bar, so set the font again for any
+			 text after it.
+
+Parameters: -int variable - The decimal variable the bar shows.
+			-int stringVariable - The string variable used to draw the bar.
+			-int cells - Length of the bar in glyphs, up to 100.
+			-long int minimum - Value at which the bar is empty.
+			-long int maximum - Value at which the bar is full.
+
+Returns: 	-None
+
+Example Code:
+	sign.win(0, 24, 287, 31);
+	sign.bar(1, 1, 48, 0, 500);
+*******************************************************************************/
+void VMDisplay::bar(int variable, int stringVariable, int cells, long int minimum, long int maximum) {
+	if(cells < 1 || cells > 100 || maximum == minimum || stringVariable < 1 || stringVariable > 16) {
+		Serial.println("Bar needs 1-100 cells, a string variable between 1-16, and a range.");
+		return;
+	}
+	VMDisplay::charSet(_fillCharSet);
+	VMDisplay::str(stringVariable, cells);
+	if(_buildWidgetCount >= VM_MAX_WIDGETS) {
+		Serial.println("No room for more widgets.");
+		return;
+	}
+	Widget &widget = _buildWidgets[_buildWidgetCount];
+	widget.type = WIDGET_BAR;
+	widget.variable = variable;
+	widget.field = stringVariable;
+	widget.size = cells;
+	widget.state = -1;	//written whole on the first update
+	widget.minimum = minimum;
+	widget.maximum = maximum;
+	_buildWidgetCount++;
+}
+
+/*******************************************************************************
+Description: Appends a color to the message being built that changes when a
+			 decimal variable crosses a limit. It colors the next dec, str, or bar
+			 field. Once the message is written, updateDecimal rewrites the
+			 message only when the variable crosses the limit. Text after the
+			 field stays in the below color, the same as with an alarm.
+
+Parameters: -int variable - The decimal variable that is checked.
+			-long int limit - Values at or above the limit use the above color.
+			-int below - The color below the limit, which is used to start.
+			-int above - The color at or above the limit.
+
+Returns: 	-None
+
+Example Code:
+	sign.threshold(1, 400, GREEN, RED);
+	sign.dec(1, 3, 0);
+*******************************************************************************/
+void VMDisplay::threshold(int variable, long int limit, int below, int above) {
+	if(below < GREEN || below > AMBER || above < GREEN || above > AMBER) {
+		Serial.println("Threshold colors must be GREEN, RED, or AMBER.");
+		return;
+	}
+	VMDisplay::color(below);
+	if(_buildWidgetCount >= VM_MAX_WIDGETS) {
+		Serial.println("No room for more widgets.");
+		return;
+	}
+	Widget &widget = _buildWidgets[_buildWidgetCount];
+	widget.type = WIDGET_THRESHOLD;
+	widget.variable = variable;
+	widget.field = 0;	//set by the next variable field
+	widget.size = 0;
+	widget.colors[0] = below;
+	widget.colors[1] = above;
+	widget.state = below;
+	widget.minimum = limit;
+	_pendingWidget = _buildWidgetCount;
+	_buildWidgetCount++;
+}
+
+/*******************************************************************************
+Description: Appends an alarm to the message being built that changes the color
+			 and blink of the next dec, str, or bar field while a decimal variable
+			 is past a limit. The alarm only clears once the variable is back past
+			 the clear level, so a noisy value near the limit doesn't keep
+			 switching it. A limit above the clear level alarms on high values,
+			 and below it on low values. The message with every alarm on is packed
+			 together with the normal message, so updateDecimal switches between
+			 them with a single send and no encoding.
+
+Parameters: -int variable - The decimal variable that is checked.
+			-long int limit - Value at which the alarm turns on.
+			-long int clear - Value at which the alarm turns back off.
+			-int color - The normal color (GREEN defaultly).
+			-int alarmColor - The color while alarmed (RED defaultly).
+			-int alarmBlink - The blink while alarmed (FAST defaultly).
+
+Returns: 	-None
+
+Example Code:
+	sign.alarm(1, 800, 750);
+	sign.dec(1, 4, 0);
+*******************************************************************************/
+void VMDisplay::alarm(int variable, long int limit, long int clear, int color, int alarmColor, int alarmBlink) {
+	if(color < GREEN || color > AMBER || alarmColor < GREEN || alarmColor > AMBER || alarmBlink < SLOW || alarmBlink > NONE) {
+		Serial.println("Alarm colors must be GREEN, RED, or AMBER and its blink SLOW, MEDIUM, FAST, or NONE.");
+		return;
+	}
+	VMDisplay::blink(NONE);
+	VMDisplay::color(color);
+	if(_buildWidgetCount >= VM_MAX_WIDGETS) {
+		Serial.println("No room for more widgets.");
+		return;
+	}
+	Widget &widget = _buildWidgets[_buildWidgetCount];
+	widget.type = WIDGET_ALARM;
+	widget.variable = variable;
+	widget.field = 0;	//set by the next variable field
+	widget.size = 0;
+	widget.colors[0] = color;
+	widget.colors[1] = alarmColor;
+	widget.blinks[0] = NONE;
+	widget.blinks[1] = alarmBlink;
+	widget.state = 0;
+	widget.minimum = limit;
+	widget.maximum = clear;
+	_pendingWidget = _buildWidgetCount;
+	_buildWidgetCount++;
+}
+
+void VMDisplay::bindWidget(int variable, bool string) {
+	if(_pendingWidget >= 0) {	//a threshold colors this field
+		_buildWidgets[_pendingWidget].field = variable;
+		_buildWidgets[_pendingWidget].size = string;
+		_pendingWidget = -1;
+	}
+}
+
+/*******************************************************************************
+Description: Finishes the message started with beginMessage and prepares it to be
+			 sent with sendMessage. If the message did not fit in the command string
+			 it is not used, and the previously written message is kept along with
+			 its bars, thresholds, and alarms, so updateDecimal keeps editing it.
+			 On little endian boards, a message that isn't minimized is sent from
+			 the buffer it was built in, as its chars already pair up as registers.
+			 It is still copied into the command string, which updateDecimal edits.
+
+Parameters: -None
+
+Returns: 	-True if the message fit and is ready to be sent.
+
+Example Code:
+*******************************************************************************/
+bool VMDisplay::endMessage() {
+	if(_overflow || _staging < 0) {
+		Serial.print("Message for display with ID ");
+		Serial.print(_ID);
+		Serial.println(" is too long and was not written.");
+		_staging = -1;
+		return false;
+	}
+	strcpy(_commandString, (const char *)_commandData[_staging]);
+	int built = _staging;
+	_staging = -1;	//the buffer is free to pack into
+	memcpy(_widgets, _buildWidgets, sizeof(_widgets));
+	_widgetCount = _buildWidgetCount;
+	_alarmed = 0;
+	if(VM_BUILT_IN_PLACE && !_minimize) {	//only the end carriage chars are missing
+		int count = _buildPos;
+		const char terminate[] = { 0x0D, 0x0D, (char)0xCC };
+		VMDisplay::packChars(_commandData[built], &count, terminate, (count % 2) ? 3 : 2);
+		_alternate = -1;
+		VMDisplay::publishPacked(built, count / 2);
+		return true;
+	}
+	VMDisplay::finishMessage();
+	return true;
+}
+
+/*******************************************************************************
+Description: Minimizes the command string if that is turned on, and packs it into
+			 the message buffers so it is ready to be sent.
+
+Parameters: -None
+
+Returns: 	-None
+
+Example Code:
+*******************************************************************************/
+void VMDisplay::finishMessage() {
+	if(_minimize) {
+		int length = _compress ? VMDisplay::compressMessage(_commandString, _commandString, VM_MAX_COMMAND, NULL, NULL)
+							   : VMDisplay::minimizeMessage(_commandString, _commandString, VM_MAX_COMMAND);
+		if(length < 0) {
+			Serial.println("Message could not be minimized and was written as is.");
+		}
+	}
+	VMDisplay::packMessage();
+}
+
+/*******************************************************************************
+Description: Returns whether the last message built was too long to fit in the
+			 command string.
+
+Parameters: -None
+
+Returns: 	-True if the last message overflowed.
+
+Example Code:
+*******************************************************************************/
+bool VMDisplay::overflowed() {
+	return _overflow;
+}
+
+/*******************************************************************************
+Description: Configure the command string with data concerning the custom settings
+			 of each enabled line. Each line takes a quarter of the display's height.
+
+Parameters: -int lineSelected - The line that contains the data being used to
+			 write the information.
+
+Returns: 	-The amount of characters appended to the command string.
+
+Example Code:
+*******************************************************************************/
+int VMDisplay::lineConfig(int lineSelected) {
+	int startPos = _buildPos;
+	bool colorRetained;
+	bool winRetained;
+	int linesClearBelow = 0;
+	const int lineHeight = _height / 4;
+	const int lineTop = lineSelected * lineHeight;
+	if(lineSelected != 0) {	//if the line above ends in the same color or has the same scrollType, data can be retained
+		int above = line[lineSelected - 1].runCount ? line[lineSelected - 1].runCount - 1 : 0;
+		colorRetained = (VMDisplay::runColor(lineSelected, 0) == VMDisplay::runColor(lineSelected - 1, above)) && line[lineSelected - 1].isEnabled;
+		winRetained = (line[lineSelected].scrollType == line[lineSelected - 1].scrollType) && line[lineSelected - 1].isEnabled;
+	}
+	else {	//line 1 (specified by 0) retains nothing
+		colorRetained = false;
+		winRetained = false;
+	}
+	for(int i = 1; i < (4 - lineSelected); i++) {	//increment lines clear below for every disabled or scroll-matching line below
+		if((line[lineSelected].scrollType == line[lineSelected + i].scrollType) || !line[lineSelected + i].isEnabled) {
+			linesClearBelow++;
+		}
+		else {
+			break;	//leave loop as soon as a non-clear line is found
+		}
+	}
+	if(!winRetained) {	//if the line's window hasn't been retained, open one as tall as the clear lines below
+		VMDisplay::win(0, lineTop, _width - 1, lineTop + ((linesClearBelow + 1) * lineHeight) - 1);
+	}
+	VMDisplay::pos(0, lineTop);	//line starting position
+
+	if(!winRetained || (line[lineSelected].scrollType >= 4 && line[lineSelected].scrollType <= 6)) {	//window being retained also means scroll is retained
+		VMDisplay::scroll(line[lineSelected].scrollType, line[lineSelected].scrollSpeed);
+	}
+	Line &selected = line[lineSelected];
+	int runs = selected.runCount ? selected.runCount : 1;
+	int length = strlen(selected.text);
+	int blink = -1;	//settings written so far, -1 until written
+	int charSet = -1;
+	int color = colorRetained ? VMDisplay::runColor(lineSelected, 0) : -1;
+	for(int i = 0; i < runs; i++) {	//write each part of the line, with only the settings that change
+		int runBlink = selected.blink;
+		int runCharSet = selected.textSize;	//textSize is stored as the character set number
+		int start = 0;
+		int end = length;
+		if(selected.runCount) {
+			if(selected.runs[i].blink != LINE_DEFAULT) {
+				runBlink = selected.runs[i].blink;
+			}
+			if(selected.runs[i].textSize != LINE_DEFAULT) {
+				runCharSet = selected.runs[i].textSize;
+			}
+			start = selected.runs[i].start;
+			end = (i + 1 < selected.runCount) ? selected.runs[i + 1].start : length;
+		}
+		if(runBlink != blink) {
+			VMDisplay::blink(runBlink);
+			blink = runBlink;
+		}
+		if(runCharSet != charSet) {
+			VMDisplay::charSet(runCharSet);
+			charSet = runCharSet;
+		}
+		if(VMDisplay::runColor(lineSelected, i) != color) {
+			color = VMDisplay::runColor(lineSelected, i);
+			VMDisplay::color(color);
+		}
+		VMDisplay::appendText(&selected.text[start], end - start);	//write user-defined text (defaultly "")
+	}
+
+	return _buildPos - startPos;
+}
+
+/*******************************************************************************
+Description: Writes the fields of one enabled line into a char array, the way
+			 writeMessage lays the line out. Kept for sketches written before the
+			 message builder; the array is not null terminated. Any message being
+			 built with beginMessage is dropped.
+
+Parameters: -int startPos - The array index to begin appending line-specific
+			 characters to.
+			-int lineSelected - The line that contains the data being used to
+			 write the information, from 0.
+			-char *arr A pointer to the char array you are writing line-specific
+			 data to.
+
+Returns: 	-The amount of characters written to the pointed array, or 0 if the
+			 line doesn't fit in the command string.
+
+Example Code:
+*******************************************************************************/
+int VMDisplay::lineConfig(int startPos, int lineSelected, char *arr) {
+	VMDisplay::beginMessage();
+	int start = _buildPos;
+	VMDisplay::lineConfig(lineSelected);
+	int written = _overflow ? 0 : _buildPos - start;
+	memcpy(&arr[startPos], (const char *)_commandData[_staging] + start, written);
+	_staging = -1;	//nothing was built to be written
+	return written;
+}
+
+/*******************************************************************************
+Description: Uses data stored in the object's members (and the line's members)
+			 to build the command message.
+
+Parameters: -char *string - A pointer to a char array to be loaded with a copy of
+			 the ASCII command message, or NULL if no copy is needed.
+
+Returns: 	-The amount of characters in the command message.
+
+Example Code:
+*******************************************************************************/
+int VMDisplay::generateString(char *string) {
+	VMDisplay::beginMessage();
+	if(_maintenanceCommand != 4) {	//a maintenance command being set will overwrite any lines defined
+		VMDisplay::append("<MTN ");
+		VMDisplay::appendNumber(_maintenanceCommand);
+		VMDisplay::append('>');
+	}
+	else {	//no maintenance command has been set
+		for(int i = 0; i < 4; i++) {	//build each line enabled
+			if(line[i].isEnabled) {
+				VMDisplay::lineConfig(i);
+			}
+		}
+	}
+	if(string != NULL) {
+		strcpy(string, _staging < 0 ? "" : (const char *)_commandData[_staging]);
+	}
+
+	return _buildPos;
+}
+
+/*******************************************************************************
+Description: Prepares the command string to be written through modbus by flipping
+			 each two characters and putting them into a single uint16_t, followed
+			 by the end carriage characters. The registers are written into the back
+			 buffer, which sendMessage never reads, and then published by swapping it
+			 with the front buffer. A send that is in progress keeps streaming the
+			 message it started with. If the message has alarms and VM_ALARM_BUFFER
+			 is 1, the variant with the other alarm state is packed as well so
+			 switching to it needs no encoding.
+
+Parameters: -None
+
+Returns: 	-None
+
+Example Code:
+*******************************************************************************/
+void VMDisplay::packMessage() {
+	_alternate = -1;	//the alternate is for the previous message, so release it
+	int back = VMDisplay::backBuffer();
+	int length = VMDisplay::packVariant(back, _alarmed);
+	if(length < 0) {
+		return;
+	}
+	VMDisplay::publishPacked(back, length);
+}
+
+/*******************************************************************************
+Description: Publishes a message packed with the current alarms, then packs the
+			 variant with the other alarm state if VM_ALARM_BUFFER is 1.
+
+Parameters: -int back - Index of the buffer the message was packed into.
+			-int length - Amount of registers in the message.
+
+Returns: 	-None
+
+Example Code:
+*******************************************************************************/
+void VMDisplay::publishPacked(int back, int length) {
+	VMDisplay::publishMessage(back, length);
+	_frontAlarmed = _alarmed;
+	uint32_t all = VMDisplay::alarmMask();
+	if(VM_ALARM_BUFFER && all) {	//precompute normal, or every alarm if the message is normal
+		uint32_t other = _alarmed ? 0 : all;
+		back = VMDisplay::backBuffer();
+		length = VMDisplay::packVariant(back, other);
+		if(length >= 0) {
+			_length[back] = length;
+			_alternateAlarmed = other;
+			_alternate = back;
+		}
+	}
+}
+
+/*******************************************************************************
+Description: Packs the command string into a message buffer. The fields of alarms
+			 whose bit is set are written in their alarm color and blink, with the
+			 normal color and blink put back after them.
+
+Parameters: -int buffer - The message buffer to write.
+			-uint32_t alarmed - A bit set for each widget that is alarmed.
+
+Returns: 	-Amount of registers written, or -1 if they don't fit in the buffer.
+
+Example Code:
+*******************************************************************************/
+int VMDisplay::packVariant(int buffer, uint32_t alarmed) {
+	if(buffer == _staging) {	//packing here loses the message being built
+		_staging = -1;
+	}
+	uint16_t *data = _commandData[buffer];
+	const char *fieldStart[VM_MAX_WIDGETS];	//fields of alarmed widgets
+	const char *fieldEnd[VM_MAX_WIDGETS];
+	for(int i = 0; i < _widgetCount; i++) {
+		fieldStart[i] = NULL;
+		fieldEnd[i] = NULL;
+		if(alarmed & (1UL << i)) {
+			fieldStart[i] = VMDisplay::findField(_widgets[i].size ? "STR" : "DEC", _widgets[i].field);
+			fieldEnd[i] = (fieldStart[i] == NULL) ? NULL : strchr(fieldStart[i], '>');
+		}
+	}
+	int count = 0;	//chars packed so far
+	char tags[12];
+	for(const char *c = _commandString; ; c++) {
+		for(int i = 0; i < _widgetCount; i++) {
+			if(c == fieldStart[i]) {	//alarm style in front of the field
+				VMDisplay::alarmTags(tags, _widgets[i].blinks[1], _widgets[i].colors[1]);
+				if(!VMDisplay::packChars(data, &count, tags, strlen(tags))) {
+					return -1;
+				}
+			}
+		}
+		if(!*c) {
+			break;
+		}
+		if(!VMDisplay::packChars(data, &count, c, 1)) {
+			return -1;
+		}
+		for(int i = 0; i < _widgetCount; i++) {
+			if(c == fieldEnd[i]) {	//normal style after the field
+				VMDisplay::alarmTags(tags, _widgets[i].blinks[0], _widgets[i].colors[0]);
+				if(!VMDisplay::packChars(data, &count, tags, strlen(tags))) {
+					return -1;
+				}
+			}
+		}
+	}
+	const char terminate[] = { 0x0D, 0x0D, (char)0xCC };	//end carriage chars, the last only if the message ends odd
+	if(!VMDisplay::packChars(data, &count, terminate, (count % 2) ? 3 : 2)) {
+		return -1;
+	}
+	return count / 2;
+}
+
+bool VMDisplay::packChars(uint16_t *data, int *count, const char text[], int length) {
+	if(*count + length > VM_MAX_REGISTERS * 2) {
+		Serial.print("Message for display with ID ");
+		Serial.print(_ID);
+		Serial.println(" is too long with its alarms and was not written.");
+		return false;
+	}
+	for(int i = 0; i < length; i++) {	//first char of each pair in the low byte
+		if(*count % 2) {
+			data[*count / 2] |= (uint16_t)(uint8_t)(text[i]) << 8;
+		}
+		else {
+			data[*count / 2] = (uint8_t)(text[i]);
+		}
+		(*count)++;
+	}
+	return true;
+}
+
+void VMDisplay::alarmTags(char *tags, int blink, int color) {
+	memcpy(tags, "<BL N><GRN>", 12);
+	tags[4] = blinkLetters[blink];
+	memcpy(tags + 7, colorNames[color], 3);
+}
+
+/*******************************************************************************
+Description: Finds the message buffer that isn't being sent or held as the
+			 alternate alarm variant, so it can be written. The back buffer is only
+			 busy while the previous message is still being sent after a new one
+			 was published (twice, with the alarm buffer), in which case this waits
+			 for that send to finish. It must not be called from an interrupt, as
+			 the send it waits for could never finish.
+
+Parameters: -None
+
+Returns: 	-Index of the buffer to write.
+
+Example Code:
+*******************************************************************************/
+int VMDisplay::backBuffer() {
+	while(true) {
+		int front = __atomic_load_n(&_front, __ATOMIC_SEQ_CST);
+		for(int i = 0; i < VM_MESSAGE_BUFFERS; i++) {
+			if(i != front && i != _alternate && i != __atomic_load_n(&_sending, __ATOMIC_SEQ_CST)) {
+				return i;
+			}
+		}
+		yield();
+	}
+}
+
+/*******************************************************************************
+Description: Makes a fully written back buffer the front buffer, so that the next
+			 call to sendMessage sends it.
+
+Parameters: -int back - Index of the buffer that was written.
+			-int length - Amount of registers in the message.
+
+Returns: 	-None
+
+Example Code:
+*******************************************************************************/
+void VMDisplay::publishMessage(int back, int length) {
+	_length[back] = length;
+	messageLength = length;
+	__atomic_store_n(&_front, (uint8_t)back, __ATOMIC_SEQ_CST);	//swap buffers
+	__atomic_add_fetch(&_published, 1, __ATOMIC_SEQ_CST);	//flag the message as not being sent
+}
+
+/*******************************************************************************
+Description: Builds the command string from the line-specific settings and
+			 prepares it to be sent. This overload is called with no parameters,
+			 and uses data previously specified using the line-specific commands.
+
+Parameters: -None
+
+Returns: 	-None
+
+Example Code:
+*******************************************************************************/
+void VMDisplay::writeMessage() {
+	VMDisplay::generateString(NULL);	//build command string into _commandString
+	VMDisplay::endMessage();
+}
+
+/*******************************************************************************
+Description: This function prepares the data passed to be written through modbus
+			 by flipping each two characters and putting them into a single
+			 uint16_t contained in the _commandData array. This overload is run by
+			 passing the entire command string in as a string literal. This is intended
 			 to make it easier to generate and edit the command string directly to
-			 produce more custom results.
+			 produce more custom results. Bars, thresholds, and alarms from a
+			 message built with beginMessage are dropped, so they can't change a
+			 message written this way.
 			 Documentation on how to write the ViewMarq command string can be found
 			 at: https://cdn.automationdirect.com/static/manuals/mduserm/appxa.pdf
 
-Parameters: -const char text[] - A string literal containing the ASCII command string
-			 typed by hand, copied from the ViewMarq software, or taken from this
-			 program's printMessage function.
+Parameters: -const char text[] - A string literal containing the ASCII command string
+			 typed by hand, copied from the ViewMarq software, or taken from this
+			 program's printMessage function.
+
+Returns: 	-None
+
+Example Code:
+*******************************************************************************/
+void VMDisplay::writeMessage(const char text[]) {
+	if(text != _commandString) {	//prevent from wiping input in case the input is _commandString
+		if(strlen(text) > VM_MAX_COMMAND - 1) {
+			Serial.print("Message for display with ID ");
+			Serial.print(_ID);
+			Serial.println(" is too long and was not written.");
+			return;
+		}
+		strcpy(_commandString, text);
+	}
+	_widgetCount = 0;	//bars, thresholds, and alarms belonged to the built message
+	_pendingWidget = -1;
+	_alarmed = 0;
+	VMDisplay::finishMessage();	//packing releases the alternate alarm variant
+}
+
+/*******************************************************************************
+Description: Copies characters to the end of an array being rewritten, checking
+			 that they fit. If the array is NULL, the characters are only counted.
+
+Parameters: -const char text[] - The characters to write.
+			-int length - The amount of characters to write.
+			-char *arr - The array being written, or NULL.
+			-int size - Size of the array.
+			-int *pos - Index to write at, advanced past what was written.
+
+Returns: 	-True if the characters fit.
+
+Example Code:
+*******************************************************************************/
+static bool emit(const char text[], int length, char *arr, int size, int *pos) {
+	if(*pos + length > size - 1) {	//leave room for the terminating null
+		return false;
+	}
+	if(arr != NULL) {
+		for(int i = 0; i < length; i++) {	//copy forwards so a rewrite in place is safe
+			arr[*pos + i] = text[i];
+		}
+	}
+	*pos += length;
+	return true;
+}
+
+static bool emitNumber(long int number, char *arr, int size, int *pos) {
+	char digits[11];
+	int count = 0;
+	do {
+		digits[10 - count] = 48 + (number % 10);
+		count++;
+		number /= 10;
+	} while(number && count < 11);
+	return emit(&digits[11 - count], count, arr, size, pos);
+}
+
+static bool emitTag(int tag, const long int args[], int argCount, char *arr, int size, int *pos) {
+	bool fits = emit("<", 1, arr, size, pos) && emit(tagNames[tag], strlen(tagNames[tag]), arr, size, pos);
+	for(int i = 0; i < argCount && fits; i++) {
+		fits = emit(" ", 1, arr, size, pos);
+		if(tag == TAG_S) {
+			fits = fits && emit(&speedLetters[args[i]], 1, arr, size, pos);
+		}
+		else if(tag == TAG_BL) {
+			fits = fits && emit(&blinkLetters[args[i]], 1, arr, size, pos);
+		}
+		else {
+			fits = fits && emitNumber(args[i], arr, size, pos);
+		}
+	}
+	return fits && emit(">", 1, arr, size, pos);
+}
+
+/*******************************************************************************
+Description: Reads an ASCII command string field by field, checking each field
+			 against the documented field set, and writes it back out. When
+			 minimizing, any color, blink, text size, scroll, or speed field that
+			 is already in effect is dropped, as are empty text fields. Scroll
+			 types are kept per window, justification per position. Arguments are
+			 written with single spaces and no leading zeros.
+			 When compressing, adjacent text fields are also merged, a position
+			 equal to the origin of a window just opened is dropped, and a window
+			 identical to the one in effect is dropped (or replaced by a position
+			 at its origin) so both share it.
+			 The output is never longer than the input, so arr may be the same
+			 array as text to rewrite it in place.
+
+Parameters: -const char text[] - The command string to read.
+			-char *arr - The array to write the result to, or NULL to only check.
+			-int size - Size of arr.
+			-bool minimize - Drop fields that don't change anything.
+			-bool compress - Also merge text fields and shared windows.
+
+Returns: 	-The length of the result, or -1 if the command string is invalid.
+
+Example Code:
+*******************************************************************************/
+int VMDisplay::rewriteMessage(const char text[], char *arr, int size, bool minimize, bool compress) {
+	VMState state = { -1, -1, -1, -1, -1 };
+	long int window[4] = { -1, -1, -1, -1 };	//window in effect, -1 when unknown
+	bool atOrigin = false;	//nothing has been written since the window was opened
+	int textEnd = -1;	//end of the last text field written, if nothing has been written after it
+	int posStart = -1;	//start and end of the last position written, for replacing it with the next one
+	int posEnd = -1;
+	int in = 0;
+	int out = 0;
+	minimize = minimize || compress;
+	while(text[in]) {
+		int fieldStart = in;
+		if(text[in] != '<') {
+			Serial.print("Text must be inside a <T> field, at character ");
+			Serial.println(in);
+			return -1;
+		}
+		in++;
+		int nameStart = in;
+		while(text[in] && text[in] != ' ' && text[in] != '>') {	//find the end of the field's name
+			in++;
+		}
+		int tag = -1;
+		for(int i = 0; i < TAG_COUNT; i++) {
+			if((int)strlen(tagNames[i]) == in - nameStart && !strncmp(tagNames[i], &text[nameStart], in - nameStart)) {
+				tag = i;
+				break;
+			}
+		}
+		if(tag < 0) {
+			Serial.print("Unknown field at character ");
+			Serial.println(fieldStart);
+			return -1;
+		}
+		long int args[4];
+		int argCount = 0;
+		bool argsValid = true;
+		while(text[in] == ' ') {	//read each space separated argument
+			while(text[in] == ' ') {
+				in++;
+			}
+			if(text[in] == '>') {
+				break;
+			}
+			if(argCount == 4) {
+				argsValid = false;
+				break;
+			}
+			if(text[in] >= '0' && text[in] <= '9') {
+				args[argCount] = 0;
+				while(text[in] >= '0' && text[in] <= '9') {
+					args[argCount] = (args[argCount] * 10) + (text[in] - 48);
+					in++;
+				}
+				if(tag == TAG_S || tag == TAG_BL) {
+					argsValid = false;
+				}
+			}
+			else {	//speed and blink arguments are a single letter
+				const char *letters = (tag == TAG_S) ? speedLetters : blinkLetters;
+				const char *found = (tag == TAG_S || tag == TAG_BL) ? strchr(letters, text[in]) : NULL;
+				if(found == NULL || !text[in]) {
+					argsValid = false;
+					break;
+				}
+				args[argCount] = found - letters;
+				in++;
+			}
+			argCount++;
+		}
+		if(text[in] != '>' || !argsValid || argCount != tagArgs[tag]) {
+			Serial.print("Invalid arguments in field at character ");
+			Serial.println(fieldStart);
+			return -1;
+		}
+		in++;
+
+		bool keep = true;
+		bool toOrigin = false;	//write a position at the window's origin instead
+		switch(tag) {
+			case TAG_CLR:	//clearing resets everything
+				state.color = -1;
+				state.blink = -1;
+				state.charSet = -1;
+				state.scrollType = -1;
+				state.scrollSpeed = -1;
+				window[0] = -1;
+				break;
+			case TAG_WIN:
+				if(compress && window[0] >= 0 && !memcmp(window, args, sizeof(window))) {	//same window again, keep sharing it
+					keep = false;
+					toOrigin = !atOrigin;
+					if(toOrigin && state.scrollType >= 4) {	//the position written instead resets justification
+						state.scrollType = -1;
+					}
+					break;
+				}
+				memcpy(window, args, sizeof(window));
+				atOrigin = true;
+				state.scrollType = -1;	//scrolling is set per window
+				state.scrollSpeed = -1;
+				break;
+			case TAG_POS:
+				if(compress && atOrigin && args[0] == window[0] && args[1] == window[1]) {	//already there
+					keep = false;
+					break;
+				}
+				atOrigin = (args[0] == window[0] && args[1] == window[1]);
+				if(state.scrollType >= 4) {	//justification is set per position
+					state.scrollType = -1;
+				}
+				break;
+			case TAG_SL: case TAG_SR: case TAG_SU: case TAG_SD: case TAG_LJ: case TAG_CJ: case TAG_RJ:
+				keep = !minimize || state.scrollType != tag - TAG_SL;
+				state.scrollType = tag - TAG_SL;
+				break;
+			case TAG_S:
+				keep = !minimize || state.scrollSpeed != args[0];
+				state.scrollSpeed = args[0];
+				break;
+			case TAG_BL:
+				keep = !minimize || state.blink != args[0];
+				state.blink = args[0];
+				break;
+			case TAG_CS:
+				if(args[0] > 11) {
+					Serial.print("Text size must be between 0 and 11, at character ");
+					Serial.println(fieldStart);
+					return -1;
+				}
+				keep = !minimize || state.charSet != args[0];
+				state.charSet = args[0];
+				break;
+			case TAG_GRN: case TAG_RED: case TAG_AMB:
+				keep = !minimize || state.color != tag - TAG_GRN;
+				state.color = tag - TAG_GRN;
+				break;
+			case TAG_DEC: case TAG_STR: case TAG_MTN:
+				atOrigin = false;
+				break;
+		}
+
+		bool fits = true;
+		if(tag == TAG_T) {	//copy the text field through to its end
+			const char *end = strstr(&text[in], "</T>");
+			if(end == NULL) {
+				Serial.print("Text field is not closed, at character ");
+				Serial.println(fieldStart);
+				return -1;
+			}
+			int textLength = end - &text[in];
+			if(!minimize || textLength) {
+				if(compress && textEnd == out) {	//continue the previous text field
+					out -= 4;
+				}
+				else {
+					fits = emit("<T>", 3, arr, size, &out);
+				}
+				fits = fits && emit(&text[in], textLength, arr, size, &out) && emit("</T>", 4, arr, size, &out);
+				textEnd = out;
+				atOrigin = atOrigin && !textLength;
+			}
+			in += textLength + 4;
+		}
+		else if(toOrigin || (keep && tag == TAG_POS)) {
+			if(compress && posEnd == out) {	//a position followed by another has no effect
+				out = posStart;
+			}
+			posStart = out;
+			fits = emitTag(TAG_POS, toOrigin ? window : args, 2, arr, size, &out);
+			posEnd = out;
+			atOrigin = atOrigin || toOrigin;
+		}
+		else if(keep) {
+			fits = emitTag(tag, args, argCount, arr, size, &out);
+		}
+		if(!fits) {
+			Serial.println("Rewritten message does not fit in the array given.");
+			return -1;
+		}
+	}
+	if(arr != NULL) {
+		arr[out] = 0;
+	}
+	return out;
+}
+
+/*******************************************************************************
+Description: Checks that an ASCII command string only uses documented fields with
+			 the right arguments. The first problem found is printed to the
+			 arduino console.
+
+Parameters: -const char text[] - The command string to check.
+
+Returns: 	-True if the command string is valid.
+
+Example Code:
+	if(sign.validateMessage("<ID 0><CLR><GRN><T>Hi</T>")) { ... }
+*******************************************************************************/
+bool VMDisplay::validateMessage(const char text[]) {
+	return VMDisplay::rewriteMessage(text, NULL, VM_MAX_COMMAND, false, false) >= 0;
+}
+
+/*******************************************************************************
+Description: Writes the shortest equivalent of an ASCII command string into a char
+			 array by dropping fields that repeat settings already in effect, such
+			 as a second <GRN> or the same <CS>. The array may be the command string
+			 itself.
+
+Parameters: -const char text[] - The command string to minimize.
+			-char *arr - A pointer to the char array to write the result to.
+			-int size - Size of arr.
+
+Returns: 	-The length of the minimized string, or -1 if the command string is
+			 invalid or the result didn't fit.
+
+Example Code:
+	char small[512];
+	sign.minimizeMessage("<ID 0><CLR><GRN><T>A</T><GRN><T>B</T>", small, 512);
+*******************************************************************************/
+int VMDisplay::minimizeMessage(const char text[], char *arr, int size) {
+	if(VMDisplay::rewriteMessage(text, NULL, size, true, false) < 0) {	//check everything before writing anything
+		return -1;
+	}
+	return VMDisplay::rewriteMessage(text, arr, size, true, false);
+}
+
+/*******************************************************************************
+Description: Writes the shortest equivalent of an ASCII command string that this
+			 library can produce into a char array. On top of minimizing, adjacent
+			 text fields are merged, positions that equal the origin of the window
+			 just opened are dropped, and repeated windows are shared. The amount of
+			 modbus transactions needed to send the message before and after is
+			 reported so that frequently sent messages can be kept to one.
+
+Parameters: -const char text[] - The command string to compress.
+			-char *arr - A pointer to the char array to write the result to.
+			-int size - Size of arr.
+			-int *chunksBefore - Set to the transactions needed for text (or NULL).
+			-int *chunksAfter - Set to the transactions needed for the result (or NULL).
+
+Returns: 	-The length of the compressed string, or -1 if the command string is
+			 invalid or the result didn't fit.
+
+Example Code:
+	int before, after;
+	sign.compressMessage(message, message, 512, &before, &after);
+*******************************************************************************/
+int VMDisplay::compressMessage(const char text[], char *arr, int size, int *chunksBefore, int *chunksAfter) {
+	if(VMDisplay::rewriteMessage(text, NULL, size, true, true) < 0) {
+		return -1;
+	}
+	if(chunksBefore != NULL) {
+		*chunksBefore = VMDisplay::chunksFor(strlen(text));
+	}
+	int length = VMDisplay::rewriteMessage(text, arr, size, true, true);
+	if(chunksAfter != NULL) {
+		*chunksAfter = VMDisplay::chunksFor(length);
+	}
+	return length;
+}
+
+/*******************************************************************************
+Description: Calculates how many modbus transactions of up to 123 registers are
+			 needed to send a command string of the given length, including the
+			 end carriage characters.
+
+Parameters: -int length - Length of the command string.
+
+Returns: 	-The amount of transactions.
+
+Example Code:
+*******************************************************************************/
+int VMDisplay::chunksFor(int length) {
+	int registers = (length / 2) + 1 + (length % 2);	//an odd length needs an extra register for the end carriage chars
+	return (registers + 122) / 123;
+}
+
+/*******************************************************************************
+Description: Returns how many modbus transactions sendMessage needs to send the
+			 message currently written.
+
+Parameters: -None
+
+Returns: 	-The amount of transactions.
+
+Example Code:
+*******************************************************************************/
+int VMDisplay::messageChunks() {
+	return (messageLength + 122) / 123;
+}
+
+/*******************************************************************************
+Description: Enables or disables minimizing every message written with either
+			 writeMessage overload or endMessage before it is sent. A message
+			 that fails validation is sent as it was written.
+
+Parameters: -bool state - Minimize written messages (disabled defaultly).
+			-bool compress - Compress instead of only minimizing (disabled defaultly).
+
+Returns: 	-None
+
+Example Code:
+*******************************************************************************/
+void VMDisplay::setMinimize(bool state, bool compress) {
+	_minimize = state;
+	_compress = compress;
+}
+
+void VMDisplay::resetMessage() {
+	for(int i = 1; i < 5; i++) {
+		VMDisplay::setText(i, "");
+		VMDisplay::setColor(i, 0);
+		VMDisplay::setTextSize(i, 0);
+		VMDisplay::setScrollType(i, 4);
+		VMDisplay::setScrollSpeed(i, 1);
+		VMDisplay::setBlink(i, 3);
+	}
+	memset(_commandString, 0, sizeof(_commandString));
+	_staging = -1;	//drop any message being built
+	_widgetCount = 0;	//widgets and alarms belonged to the old message
+	_pendingWidget = -1;
+	_alarmed = 0;
+	_alternate = -1;	//so an alarm can't swap the old message back in
+	VMDisplay::publishMessage(VMDisplay::backBuffer(), 0);	//nothing left to send
+	_frontAlarmed = 0;
+}
+
+/*******************************************************************************
+Description: Prints out the command message to the arduino console. The intent of
+			 this function is to allow for troubleshooting, or to enable users to
+			 copy the generated command message and then modify it to their needs
+			 with the alternate writeMessage overload.
+
+Parameters: -None
+
+Returns: 	-None
+
+Example Code:
+*******************************************************************************/
+void VMDisplay::printMessage() {
+	for(int i = 0; i < strlen(_commandString); i++) {
+		Serial.print(_commandString[i]);	//print each char in the string
+	}
+	Serial.println();	//new line
+}
+
+/*******************************************************************************
+Description: Returns the command string into a char array passed into the function
+			 by the user. The intent of this function is to store the command string
+			 so that users can pass it to the alternate writeMessage overload with
+			 or without modifying it.
+
+Parameters: -None
+
+Returns: 	-None
+
+Example Code:
+*******************************************************************************/
+void VMDisplay::returnMessage(char *arr) {
+	for(int i = 0; i < strlen(_commandString); i++) {
+		arr[i] = _commandString[i];	//print each char in the array passed
+	}
+}
+
+/*******************************************************************************
+Description: Establishes connection with the Modbus TCP server to allow for
+			 communications with the ViewMarq display.
+
+Parameters: -None
+
+Returns: 	-None
+
+Example Code:
+*******************************************************************************/
+void VMDisplay::changeIPAddress(IPAddress &ip) {
+	for(int i = 0; i < 4; i++) {
+		address[i] = ip[i];
+	}
+	VMClient.stop();	//the next communication connects to the new address
+}
+
+/*******************************************************************************
+Description: Establishes connection with the Modbus TCP server to allow for
+			 communications with the ViewMarq display. An open connection is
+			 reused. When a new connection has to be opened, it is flagged so
+			 that maintain can check whether the display restarted meanwhile.
+
+Parameters: -None
+
+Returns: 	-None
+
+Example Code:
+*******************************************************************************/
+void VMDisplay::connect() {
+	while(!VMDisplay::tryConnect()) {	//try until the display answers
+		Serial.print("Modbus TCP Client on display with ID ");
+		Serial.print(_ID);
+		Serial.println(" failed!");
+		delay(500);
+	}
+}
+
+/*******************************************************************************
+Description: Makes a single attempt to connect to the display, reusing an open
+			 session, without waiting or retrying if the display doesn't answer.
+			 Displays can share a communication client, but only one of them can
+			 hold its connection. A display only reuses a connection it opened
+			 itself, so the next display to use the client reconnects it to its
+			 own address.
+
+Parameters: -None
+
+Returns: 	-True if the display is connected.
+
+Example Code:
+*******************************************************************************/
+bool VMDisplay::tryConnect() {
+	if(_session && VMClient.connected()) {	//keep using the open session
+		return true;
+	}
+	VMClient.stop();	//clean up the closed session, or another display's on a shared client
+	_newSession = true;
+	_session = VMClient.begin(address);	//begin modbus server on this display's IP
+	if(_session) {
+		for(int i = 0; i < _displayCount; i++) {	//displays sharing the client lost their session
+			if(_displays[i] != this && _displays[i]->_client == _client) {
+				_displays[i]->_session = false;
+			}
+		}
+	}
+	return _session;
+}
+
+/*******************************************************************************
+Description: Brings up every display that has been constructed at once, rather
+			 than one after another. Each pass makes one connection attempt to
+			 every display that hasn't started yet and sends its message as soon
+			 as it connects, so a display that is still booting never holds up
+			 the others. A display has only started once its message was sent. Write each display's message before calling this so it
+			 is ready to send. The time each display took to show its message is
+			 kept for startupTime and printStartupReport.
+			 Connection attempts are only as short as the communication client
+			 allows; lowering its connection timeout (like EthernetClient's
+			 setConnectionTimeout) shortens each pass.
+
+Parameters: -unsigned long timeout - Milliseconds to keep trying displays that
+			 haven't started.
+
+Returns: 	-The amount of displays that started.
+
+Example Code:
+	signA.writeMessage();
+	signB.writeMessage();
+	VMDisplay::startDisplays(30000);
+	VMDisplay::printStartupReport();
+*******************************************************************************/
+int VMDisplay::startDisplays(unsigned long timeout) {
+	unsigned long start = millis();
+	int started = 0;
+	for(int i = 0; i < _displayCount; i++) {
+		_displays[i]->_startupTime = 0;
+		_displays[i]->_started = false;
+	}
+	while(started < _displayCount && millis() - start < timeout) {
+		for(int i = 0; i < _displayCount; i++) {	//one attempt per display each pass
+			VMDisplay *display = _displays[i];
+			if(display->_started || !display->tryConnect() || !display->sendMessage()) {	//a display whose modbus server isn't up yet is tried again
+				continue;
+			}
+			display->_startupTime = millis() - start;
+			display->_started = true;
+			started++;
+		}
+		yield();	//let the network stack and watchdog run between passes
+	}
+	return started;
+}
+
+/*******************************************************************************
+Description: Returns how long the display took to show its message during the
+			 last call to startDisplays.
+
+Parameters: -None
+
+Returns: 	-Milliseconds from the start of startDisplays until the display's
+			 message was sent, or 0 if it didn't start.
+
+Example Code:
+*******************************************************************************/
+unsigned long VMDisplay::startupTime() {
+	return _startupTime;
+}
+
+/*******************************************************************************
+Description: Prints the ID, IP address, and time to show its message of every
+			 display from the last call to startDisplays to the arduino console.
+
+Parameters: -None
+
+Returns: 	-None
+
+Example Code:
+*******************************************************************************/
+void VMDisplay::printStartupReport() {
+	for(int i = 0; i < _displayCount; i++) {
+		VMDisplay *display = _displays[i];
+		Serial.print("Display with ID ");
+		Serial.print(display->_ID);
+		Serial.print(" at ");
+		for(int j = 0; j < 4; j++) {
+			Serial.print(display->address[j]);
+			Serial.print(j < 3 ? "." : ": ");
+		}
+		if(display->_started) {
+			Serial.print(display->_startupTime);
+			Serial.println(" ms");
+		}
+		else {
+			Serial.println("did not start");
+		}
+	}
+}
+
+/*******************************************************************************
+Description: Enables or disables queued mode. In queued mode, the update and
+			 write functions never perform any modbus communication themselves:
+			 variable writes are placed on a lock-free queue and messages are
+			 published to the front buffer, and a separate task calling poll does
+			 all of the communication. This lets one task or core produce values
+			 while another drives the network. Each display should only be
+			 updated from one task, and only polled from one task.
+
+Parameters: -bool state - Use queued mode (disabled defaultly).
+
+Returns: 	-None
+
+Example Code:
+	sign.setQueued(true);
+	//on the producing core
+	sign.updateDecimal(1, value, false);
+	//on the network core
+	sign.poll();
+*******************************************************************************/
+void VMDisplay::setQueued(bool state) {
+	_queued = state;
+}
+
+/*******************************************************************************
+Description: Writes a variable's registers on the display, or places them on the
+			 queue for poll to write in queued mode. If the queue is full, this
+			 waits for poll to make room.
+
+Parameters: -int address - The first register to write.
+			-const uint16_t *data - The values to write.
+			-int count - Amount of registers to write, at most 50.
+
+Returns: 	-None
+
+Example Code:
+*******************************************************************************/
+void VMDisplay::writeVariable(int address, const uint16_t *data, int count) {
+	if(!_queued) {
+		VMDisplay::connect();	//ensure connection to the correct display
+		VMDisplay::rememberRegisters(address, data, count);
+		VMDisplay::writeRegisters(address, data, count);
+		return;
+	}
+	uint8_t head = _queueHead;	//only this side ever writes the head
+	while((head + (2 * VM_QUEUE_DEPTH) - __atomic_load_n(&_queueTail, __ATOMIC_ACQUIRE)) % (2 * VM_QUEUE_DEPTH) == VM_QUEUE_DEPTH) {	//wait while the queue is full
+		yield();
+	}
+	QueuedWrite &entry = _queue[head % VM_QUEUE_DEPTH];	//counting to twice the depth tells a full queue from an empty one
+	entry.address = address;
+	entry.count = count;
+	memcpy(entry.data, data, count * sizeof(uint16_t));
+	__atomic_store_n(&_queueHead, (uint8_t)((head + 1) % (2 * VM_QUEUE_DEPTH)), __ATOMIC_RELEASE);	//hand the entry to poll
+}
+
+/*******************************************************************************
+Description: Performs all of the modbus communication for a display in queued
+			 mode. A newly written message is sent first, followed by every
+			 variable write waiting on the queue in the order they were made.
+			 Call this repeatedly from the task that owns the network.
+
+Parameters: -None
 
 Returns: 	-None
 
 Example Code:
 *******************************************************************************/
-void VMDisplay::writeMessage(const char text[]) {
-	uint16_t temp[512];
-	int tempPos = 0;
-	memset(temp, 0, 512);
-	if((int)text != (int)&_commandString) {	//prevent from wiping input in case the input is _commandString
-		memset(_commandString, 0, 512);
-		strcpy(_commandString, text);
+void VMDisplay::poll() {
+	VMDisplay::sendMessage();	//sends only if a new message was published
+	uint8_t tail = _queueTail;	//only this side ever writes the tail
+	uint8_t head = __atomic_load_n(&_queueHead, __ATOMIC_ACQUIRE);	//writes queued later wait for the next call, so a busy producer can't keep poll from returning
+	while(tail != head) {
+		QueuedWrite &entry = _queue[tail % VM_QUEUE_DEPTH];
+		VMDisplay::rememberRegisters(entry.address, entry.data, entry.count);
+		VMDisplay::writeRegisters(entry.address, entry.data, entry.count);
+		tail = (tail + 1) % (2 * VM_QUEUE_DEPTH);
+		__atomic_store_n(&_queueTail, tail, __ATOMIC_RELEASE);	//free the entry
+	}
+}
+
+/*******************************************************************************
+Description: Keeps what the display should hold in its decimal variables and
+			 remembered string variables, for verifyVariables and replayState.
+			 It runs on the task that talks to the display, which is poll's task
+			 in queued mode, so those never read registers being packed.
+
+Parameters: -int address - The first register written.
+			-const uint16_t *data - The values written.
+			-int count - Amount of registers written.
+
+Returns: 	-None
+
+Example Code:
+*******************************************************************************/
+void VMDisplay::rememberRegisters(int address, const uint16_t *data, int count) {
+	for(int i = 0; i < count; i++) {
+		int decimal = address + i - 99;	//two registers per decimal variable
+		int string = address + i - 199;	//fifty registers per string variable
+		if(decimal >= 0 && decimal < 64) {
+			_decValue[decimal] = data[i];
+			_decWritten |= (1UL << (decimal / 2));
+		}
+		else if(string >= 0 && string < VM_SHADOW_STRINGS * 50) {
+			_strValue[string / 50][string % 50] = data[i];
+			_strWritten |= (1U << (string / 50));
+		}
+	}
+}
+
+/*******************************************************************************
+Description: Writes a block of holding registers on the display in a single modbus
+			 transaction.
+
+Parameters: -int address - The first register to write.
+			-const uint16_t *data - The values to write.
+			-int count - Amount of registers to write, at most 123.
+
+Returns: 	-True if the transaction succeeded.
+
+Example Code:
+*******************************************************************************/
+bool VMDisplay::writeRegisters(int address, const uint16_t *data, int count) {
+	unsigned long time = millis();
+	VMClient.beginTransmission(HOLDING_REGISTERS, address, count);
+	for(int i = 0; i < count; i++) {
+		VMClient.write(data[i]);
+	}
+	bool written = VMClient.endTransmission();
+	if(_capture != NULL) {
+		VMDisplay::captureRecord(time, address, data, count, written ? CAPTURE_SUCCEEDED : 0);
+	}
+	if(!written) {
+		VMClient.stop();	//drop the session so the next connect opens a new one
+		return false;
+	}
+	return true;
+}
+
+/*******************************************************************************
+Description: Reads a single holding register on the display, recording the read
+			 if transactions are being captured.
+
+Parameters: -int address - The register to read.
+
+Returns: 	-The register's value, or -1 if it couldn't be read.
+
+Example Code:
+*******************************************************************************/
+long int VMDisplay::readRegister(int address) {
+	unsigned long time = millis();
+	long int value = VMClient.holdingRegisterRead(address);
+	if(_capture != NULL) {
+		uint16_t read = value;
+		VMDisplay::captureRecord(time, address, (value < 0) ? NULL : &read, 1, (value < 0) ? CAPTURE_READ : CAPTURE_READ | CAPTURE_SUCCEEDED);
+	}
+	return value;
+}
+
+/*******************************************************************************
+Description: Records every modbus transaction made to the display into a binary
+			 log, such as a file on an SD card. The log starts with the four
+			 characters "VMC1". Each transaction is then recorded, little endian,
+			 as the millis it started at (4 bytes), the first register (2 bytes),
+			 the amount of registers (1 byte), and its status (1 byte), followed
+			 by the registers (2 bytes each). The status has CAPTURE_SUCCEEDED set
+			 if the transaction succeeded, and CAPTURE_READ set if it read
+			 registers rather than writing them. Registers follow every write,
+			 and every read that succeeded. Pass NULL to stop recording.
+
+Parameters: -Print *sink - Where the log is written, or NULL.
+
+Returns: 	-None
+
+Example Code:
+	File log = SD.open("sign.vmc", FILE_WRITE);
+	sign.setCapture(&log);
+*******************************************************************************/
+void VMDisplay::setCapture(Print *sink) {
+	_capture = sink;
+	if(_capture != NULL) {
+		_capture->write((const uint8_t *)"VMC1", 4);
+	}
+}
+
+void VMDisplay::captureRecord(unsigned long time, int address, const uint16_t *data, int count, uint8_t status) {
+	uint8_t header[8] = { (uint8_t)time, (uint8_t)(time >> 8), (uint8_t)(time >> 16), (uint8_t)(time >> 24),
+						  (uint8_t)address, (uint8_t)(address >> 8), (uint8_t)count, status };
+	_capture->write(header, 8);
+	for(int i = 0; data != NULL && i < count; i++) {	//without data, the caller records the registers
+		VMDisplay::captureRegister(data[i]);
+	}
+}
+
+void VMDisplay::captureRegister(uint16_t value) {
+	uint8_t bytes[2] = { (uint8_t)value, (uint8_t)(value >> 8) };
+	_capture->write(bytes, 2);
+}
+
+/*******************************************************************************
+Description: Sends a log recorded with setCapture to this display, one
+			 transaction at a time, streaming the registers straight from the log.
+			 Transactions are spaced as they were recorded, divided by the speed,
+			 so 4 replays four times faster and 0 replays as fast as the display
+			 takes them. Transactions that failed when recorded are sent again as
+			 well. Reads are skipped, since they didn't change the display. In
+			 queued mode, call this from the task that calls poll.
+
+Parameters: -Stream &log - The recorded log, from its start.
+			-float speed - How many times faster than recorded to replay (1
+			 defaultly), or 0 for no waiting.
+
+Returns: 	-Amount of transactions replayed, or -1 if the log doesn't start
+			 like one written by setCapture.
+
+Example Code:
+	File log = SD.open("sign.vmc");
+	sign.replayCapture(log, 4);
+*******************************************************************************/
+long int VMDisplay::replayCapture(Stream &log, float speed) {
+	uint8_t header[8];
+	if(log.readBytes(header, 4) != 4 || memcmp(header, "VMC1", 4)) {
+		Serial.println("Log was not recorded with setCapture.");
+		return -1;
+	}
+	long int replayed = 0;
+	unsigned long first = 0;
+	unsigned long start = millis();
+	while(log.readBytes(header, 8) == 8) {
+		unsigned long time = header[0] | ((unsigned long)header[1] << 8) | ((unsigned long)header[2] << 16) | ((unsigned long)header[3] << 24);
+		int address = header[4] | (header[5] << 8);
+		int count = header[6];
+		if(header[7] & CAPTURE_READ) {	//skip the registers read, if any
+			uint8_t bytes[2];
+			for(int i = 0; (header[7] & CAPTURE_SUCCEEDED) && i < count; i++) {
+				if(log.readBytes(bytes, 2) != 2) {
+					Serial.println("Log ended in the middle of a transaction.");
+					return replayed;
+				}
+			}
+			continue;
+		}
+		if(!replayed) {
+			first = time;
+		}
+		if(speed > 0) {	//wait until the transaction's time, scaled
+			unsigned long due = (unsigned long)((time - first) / speed);
+			while(millis() - start < due) {
+				yield();
+			}
+		}
+		VMDisplay::connect();
+		VMClient.beginTransmission(HOLDING_REGISTERS, address, count);
+		for(int i = 0; i < count; i++) {	//stream each register from the log
+			uint8_t bytes[2];
+			if(log.readBytes(bytes, 2) != 2) {
+				Serial.println("Log ended in the middle of a transaction.");	//nothing is sent until endTransmission
+				return replayed;
+			}
+			VMClient.write(bytes[0] | (bytes[1] << 8));
+		}
+		if(!VMClient.endTransmission()) {
+			VMClient.stop();
+		}
+		replayed++;
+	}
+	return replayed;
+}
+
+/*******************************************************************************
+Description: Sends the front message buffer to the display using the modbus TCP
+			 server. It does this in one or more transactions of, at most, 246
+			 bytes. The front buffer is claimed for the whole send, so a message
+			 published meanwhile is written into the other buffer and sent on the
+			 next call rather than mixing into this one. If a transaction fails,
+			 the rest of the message isn't sent and the next call sends the whole
+			 message again, so the display never keeps part of an old message.
+
+Parameters: -None
+
+Returns: 	-True if the message was sent or had already been sent, false if a
+			 transaction failed.
+
+Example Code:
+	if(!display.sendMessage()) {
+		Serial.println("Message will be resent on the next call.");
+	}
+*******************************************************************************/
+bool VMDisplay::sendMessage() {
+	VMDisplay::connect();	//ensure connection to the correct modbus server
+	uint16_t published = __atomic_load_n(&_published, __ATOMIC_SEQ_CST);
+	if(published == _sent) {	//make sure the current message hasn't already been written
+		return true;
+	}
+	int front = VMDisplay::claimFront();
+	int length = _length[front];
+	for(int commandPos = 0; commandPos < length; commandPos += 123) {	//make a transmission of up to 123 uint16_ts at a time
+		int count = (length - commandPos < 123) ? length - commandPos : 123;
+		if(!VMDisplay::writeRegisters(10999 + commandPos, &_commandData[front][commandPos], count)) {
+			__atomic_store_n(&_sending, (int8_t)-1, __ATOMIC_SEQ_CST);	//leave _sent so the whole message is sent again
+			return false;
+		}
+	}
+	__atomic_store_n(&_sending, (int8_t)-1, __ATOMIC_SEQ_CST);	//release the buffer
+	_sent = published;	//mark this message as being written
+	return true;
+}
+
+/*******************************************************************************
+Description: Claims the front message buffer so that it can be read without a
+			 writer reusing it. Release it by setting _sending back to -1.
+
+Parameters: -None
+
+Returns: 	-Index of the front buffer.
+
+Example Code:
+*******************************************************************************/
+int VMDisplay::claimFront() {
+	int front;
+	do {	//claim the front buffer, checking it wasn't swapped before the claim took effect
+		front = __atomic_load_n(&_front, __ATOMIC_SEQ_CST);
+		__atomic_store_n(&_sending, (int8_t)front, __ATOMIC_SEQ_CST);
+	} while(front != __atomic_load_n(&_front, __ATOMIC_SEQ_CST));
+	return front;
+}
+
+/*******************************************************************************
+Description: Checks that the display still holds the message that was sent by
+			 reading back a few of its message registers, spread evenly from the
+			 first to the end carriage characters, and comparing them with the
+			 front buffer. The message is only resent if they don't match, so
+			 calling this periodically recovers from a display losing its message
+			 (like after a power cycle) without continuously rewriting it.
+			 A message that hasn't been sent yet is simply sent. In queued mode,
+			 call this from the task that calls poll.
+
+Parameters: -int samples - Amount of registers to read back (4 defaultly).
+
+Returns: 	-VERIFY_OK if the display holds the message, VERIFY_RESENT if it
+			 was sent again, or VERIFY_UNAVAILABLE if the registers can't be read.
+
+Example Code:
+	if(sign.verifyMessage() == VERIFY_RESENT) {
+		Serial.println("Display lost its message.");
 	}
-	memset(_commandData, 0, 512);
-	bool endedOdd = false;
-	char terminate[] = { 0x0D, 0x0D, 0xCC };
-	strcpy(_commandString, text);
-	_completed = false;
-	for(int i = 0; i < strlen(text); i += 2) {
-		if(i + 1 > strlen(text) - 1) {
-			temp[tempPos] = ((uint16_t)(terminate[0]) * 256) + (uint16_t)(text[i]);
-			temp[tempPos + 1] = ((uint16_t)(terminate[2]) * 256) + (uint16_t)(terminate[1]);
-			tempPos += 2;
-			endedOdd = true;
+*******************************************************************************/
+int VMDisplay::verifyMessage(int samples) {
+	VMDisplay::connect();
+	uint16_t published = __atomic_load_n(&_published, __ATOMIC_SEQ_CST);
+	if(published != _sent) {	//not sent yet, so there is nothing to compare
+		VMDisplay::sendMessage();
+		return VERIFY_RESENT;
+	}
+	int front = VMDisplay::claimFront();
+	int length = _length[front];
+	int result = VERIFY_OK;
+	if(samples < 2) {
+		samples = 2;	//always check the first register and the end carriage chars
+	}
+	for(int i = 0; i < samples && length > 0; i++) {
+		int position = ((long)i * (length - 1)) / (samples - 1);
+		long value = VMDisplay::readRegister(10999 + position);
+		if(value < 0) {
+			result = VERIFY_UNAVAILABLE;
 			break;
 		}
-		else {
-			temp[tempPos] = ((uint16_t)(text[i + 1]) * 256) + (uint16_t)(text[i]);
+		if((uint16_t)value != _commandData[front][position]) {
+			result = VERIFY_RESENT;
+			break;
 		}
-		tempPos++;
 	}
-	if(!endedOdd) {
-		temp[tempPos] = ((uint16_t)(terminate[1]) * 256) + (uint16_t)(terminate[0]);
-		tempPos++;
+	__atomic_store_n(&_sending, (int8_t)-1, __ATOMIC_SEQ_CST);
+	if(result == VERIFY_RESENT) {
+		_sent = published - 1;	//flag the message as not being sent
+		VMDisplay::sendMessage();
+	}
+	return result;
+}
+
+/*******************************************************************************
+Description: Checks that the display still holds the last value written to each
+			 decimal and string variable. Every decimal variable written is read
+			 back in a single transaction, and each string variable written is
+			 checked by its first and last registers holding characters. Only
+			 the variables that don't match are written again. String variables
+			 past VM_SHADOW_STRINGS aren't remembered, so they aren't checked. In
+			 queued mode, call this from the task that calls poll.
+
+Parameters: -None
+
+Returns: 	-VERIFY_OK if every variable matched, VERIFY_RESENT if any were
+			 written again, or VERIFY_UNAVAILABLE if the registers can't be read.
+
+Example Code:
+*******************************************************************************/
+int VMDisplay::verifyVariables() {
+	int result = VERIFY_OK;
+	VMDisplay::connect();
+	if(_decWritten) {
+		int first = 0;
+		int last = 31;
+		while(!(_decWritten & (1UL << first))) {
+			first++;
+		}
+		while(!(_decWritten & (1UL << last))) {
+			last--;
+		}
+		int count = (last - first + 1) * 2;
+		unsigned long time = millis();
+		bool read = VMClient.requestFrom(HOLDING_REGISTERS, 99 + (first * 2), count) == count;
+		if(_capture != NULL) {	//the registers are recorded as they are read
+			VMDisplay::captureRecord(time, 99 + (first * 2), NULL, count, read ? CAPTURE_READ | CAPTURE_SUCCEEDED : CAPTURE_READ);
+		}
+		if(!read) {
+			return VERIFY_UNAVAILABLE;
+		}
+		uint32_t stale = 0;	//variables to write again once the read is recorded
+		for(int i = first; i <= last; i++) {
+			uint16_t high = VMClient.read();
+			uint16_t low = VMClient.read();
+			if(_capture != NULL) {
+				VMDisplay::captureRegister(high);
+				VMDisplay::captureRegister(low);
+			}
+			if((_decWritten & (1UL << i)) && (high != _decValue[i * 2] || low != _decValue[(i * 2) + 1])) {
+				stale |= (1UL << i);
+			}
+		}
+		for(int i = first; i <= last; i++) {
+			if(stale & (1UL << i)) {
+				VMDisplay::writeRegisters(99 + (i * 2), &_decValue[i * 2], 2);
+				result = VERIFY_RESENT;
+			}
+		}
 	}
-	for(int i = 0; i < (sizeof(temp) / sizeof(uint16_t)); i++) {
-		if(i > tempPos) {
-			temp[i] = 0;
+	for(int i = 0; i < VM_SHADOW_STRINGS; i++) {
+		if(!(_strWritten & (1U << i))) {
+			continue;
+		}
+		int last = 49;
+		while(last > 0 && !_strValue[i][last]) {	//find the last register holding characters
+			last--;
+		}
+		long first = VMDisplay::readRegister(199 + (i * 50));
+		long end = VMDisplay::readRegister(199 + (i * 50) + last);
+		if(first < 0 || end < 0) {
+			return VERIFY_UNAVAILABLE;
+		}
+		if((uint16_t)first != _strValue[i][0] || (uint16_t)end != _strValue[i][last]) {
+			VMDisplay::writeRegisters(199 + (i * 50), _strValue[i], 50);
+			result = VERIFY_RESENT;
 		}
-		_commandData[i] = temp[i];
 	}
-	messageLength = tempPos;
+	return result;
 }
 
-void VMDisplay::resetMessage() {
-	for(int i = 1; i < 5; i++) {
-		VMDisplay::setText(i, "");
-		VMDisplay::setColor(i, 0);
-		VMDisplay::setTextSize(i, 0);
-		VMDisplay::setScrollType(i, 4);
-		VMDisplay::setScrollSpeed(i, 1);
-		VMDisplay::setBlink(i, 3);
+/*******************************************************************************
+Description: Keeps the display showing what it should after the connection drops
+			 or the display loses power. Whenever a new session had to be opened,
+			 and every VM_PROBE_INTERVAL milliseconds while it stays open (a display
+			 that restarts can leave the session looking open), the display's
+			 message registers are checked. If the message is gone, the message
+			 and the last value of every variable are sent again using
+			 replayState. If the display doesn't answer, the session is closed and
+			 checked again once it reopens. Call this periodically (from the task
+			 that calls poll in queued mode).
+
+Parameters: -None
+
+Returns: 	-True if the display's state was replayed.
+
+Example Code:
+	void loop() {
+		sign.maintain();
+		...
+	}
+*******************************************************************************/
+bool VMDisplay::maintain() {
+	VMDisplay::connect();
+	if(!_newSession && millis() - _probed < VM_PROBE_INTERVAL) {
+		return false;
+	}
+	_probed = millis();
+	if(__atomic_load_n(&_published, __ATOMIC_SEQ_CST) != _sent) {	//an unsent message is sent by sendMessage as usual
+		_newSession = false;
+		return false;
 	}
-	_completed = false;
-	messageLength = 0;
-	memset(_commandString, 0, 512);
-	memset(_commandData, 0, 512);
+	int front = VMDisplay::claimFront();
+	int length = _length[front];
+	long first = 0;
+	long last = 0;
+	if(length > 0) {	//check the first register and the end carriage chars
+		first = VMDisplay::readRegister(10999);
+		last = (first < 0) ? -1 : VMDisplay::readRegister(10999 + length - 1);
+	}
+	bool held = length == 0 || ((uint16_t)first == _commandData[front][0] && (uint16_t)last == _commandData[front][length - 1]);
+	__atomic_store_n(&_sending, (int8_t)-1, __ATOMIC_SEQ_CST);
+	if(first < 0 || last < 0) {	//unavailable, which says nothing about the message
+		VMClient.stop();	//the next connect opens a new session, which is checked again
+		return false;
+	}
+	_newSession = false;
+	if(held) {
+		return false;
+	}
+	VMDisplay::replayState();
+	return true;
 }
 
 /*******************************************************************************
-Description: Prints out the command message to the arduino console. The intent of
-			 this function is to allow for troubleshooting, or to enable users to
-			 copy the generated command message and then modify it to their needs
-			 with the alternate writeMessage overload.
+Description: Sends the current message and the last value written to every
+			 decimal variable and remembered string variable again, in as few
+			 transactions as possible. Decimal variables written next to each
+			 other go in one transaction, and so do pairs of neighbouring string
+			 variables. Variables that were never written are left alone.
 
 Parameters: -None
 
@@ -831,107 +3221,252 @@ Returns: 	-None
 
 Example Code:
 *******************************************************************************/
-void VMDisplay::printMessage() {
-	for(int i = 0; i < strlen(_commandString); i++) {
-		Serial.print(_commandString[i]);	//print each char in the string
+void VMDisplay::replayState() {
+	_sent = __atomic_load_n(&_published, __ATOMIC_SEQ_CST) - 1;	//flag the message as not being sent
+	VMDisplay::sendMessage();
+	for(int i = 0; i < 32; i++) {	//write each run of neighbouring decimal variables at once
+		if(!(_decWritten & (1UL << i))) {
+			continue;
+		}
+		int run = 1;
+		while(i + run < 32 && (_decWritten & (1UL << (i + run)))) {
+			run++;
+		}
+		VMDisplay::writeRegisters(99 + (i * 2), &_decValue[i * 2], run * 2);
+		i += run - 1;
+	}
+	for(int i = 0; i < VM_SHADOW_STRINGS; i++) {	//string variables are 50 registers, so two fit in a transaction
+		if(!(_strWritten & (1U << i))) {
+			continue;
+		}
+		int run = (i + 1 < VM_SHADOW_STRINGS && (_strWritten & (1U << (i + 1)))) ? 2 : 1;
+		VMDisplay::writeRegisters(199 + (i * 50), _strValue[i], run * 50);
+		i += run - 1;
 	}
-	Serial.println();	//new line
 }
 
 /*******************************************************************************
-Description: Returns the command string into a char array passed into the function
-			 by the user. The intent of this function is to store the command string
-			 so that users can pass it to the alternate writeMessage overload with
-			 or without modifying it.
+Description: Turns every pixel of the canvas off.
 
 Parameters: -None
 
 Returns: 	-None
 
 Example Code:
+	levels.clear();
 *******************************************************************************/
-void VMDisplay::returnMessage(char *arr) {
-	for(int i = 0; i < strlen(_commandString); i++) {
-		arr[i] = _commandString[i];	//print each char in the array passed
+void VMCanvas::clear() {
+	VMCanvas::fillRect(0, 0, VM_CANVAS_WIDTH, VM_CANVAS_HEIGHT, PIXEL_OFF);
+}
+
+/*******************************************************************************
+Description: Sets the color lit pixels are shown in when the canvas is built with
+			 1 bit per pixel. Canvases with 2 bits per pixel keep each pixel's
+			 own color.
+
+Parameters: -int color - Use constants RED, GREEN, and AMBER.
+
+Returns: 	-None
+
+Example Code:
+	levels.setInk(AMBER);
+*******************************************************************************/
+void VMCanvas::setInk(int color) {
+	if(color < GREEN || color > AMBER) {
+		Serial.println("Color must be GREEN, RED, or AMBER.");
+		return;
+	}
+	if(VM_CANVAS_BITS == 1 && color != _ink) {	//every lit pixel changes
+		_dirtyX1 = 0;
+		_dirtyY1 = 0;
+		_dirtyX2 = VM_CANVAS_WIDTH - 1;
+		_dirtyY2 = VM_CANVAS_HEIGHT - 1;
 	}
+	_ink = color;
 }
 
 /*******************************************************************************
-Description: Establishes connection with the Modbus TCP server to allow for
-			 communications with the ViewMarq display.
+Description: Sets a pixel of the canvas, growing the dirty region if it changes.
+			 Pixels outside the canvas are ignored.
 
-Parameters: -None
+Parameters: -int x, int y - The pixel.
+			-int color - Use constants RED, GREEN, AMBER, and PIXEL_OFF.
 
 Returns: 	-None
 
 Example Code:
+	levels.setPixel(0, 0, RED);
 *******************************************************************************/
-void VMDisplay::changeIPAddress(IPAddress &ip) {
-	for(int i = 0; i < 4; i++) {
-		address[i] = ip[i];
+void VMCanvas::setPixel(int x, int y, int color) {
+	if(x < 0 || y < 0 || x >= VM_CANVAS_WIDTH || y >= VM_CANVAS_HEIGHT) {
+		return;
+	}
+	uint8_t value = (color < GREEN || color > AMBER) ? 0 : ((VM_CANVAS_BITS == 1) ? 1 : color + 1);
+	int bit = x * VM_CANVAS_BITS;
+	uint8_t *pixels = &_pixels[y * VM_CANVAS_STRIDE + (bit >> 3)];
+	uint8_t mask = ((1 << VM_CANVAS_BITS) - 1) << (bit & 7);
+	uint8_t updated = (*pixels & ~mask) | (value << (bit & 7));
+	if(updated == *pixels) {	//unchanged pixels don't dirty the canvas
+		return;
+	}
+	*pixels = updated;
+	if(_dirtyX1 > _dirtyX2) {
+		_dirtyX1 = _dirtyX2 = x;
+		_dirtyY1 = _dirtyY2 = y;
+		return;
+	}
+	if(x < _dirtyX1) {
+		_dirtyX1 = x;
+	}
+	if(x > _dirtyX2) {
+		_dirtyX2 = x;
+	}
+	if(y < _dirtyY1) {
+		_dirtyY1 = y;
+	}
+	if(y > _dirtyY2) {
+		_dirtyY2 = y;
 	}
 }
 
 /*******************************************************************************
-Description: Establishes connection with the Modbus TCP server to allow for
-			 communications with the ViewMarq display.
+Description: Reads a pixel of the canvas.
 
-Parameters: -None
+Parameters: -int x, int y - The pixel.
+
+Returns: 	-The pixel's color, or PIXEL_OFF if it is off or outside the canvas.
+
+Example Code:
+	if(levels.getPixel(0, 0) == RED) {...}
+*******************************************************************************/
+int VMCanvas::getPixel(int x, int y) {
+	if(x < 0 || y < 0 || x >= VM_CANVAS_WIDTH || y >= VM_CANVAS_HEIGHT) {
+		return PIXEL_OFF;
+	}
+	int bit = x * VM_CANVAS_BITS;
+	int value = (_pixels[y * VM_CANVAS_STRIDE + (bit >> 3)] >> (bit & 7)) & ((1 << VM_CANVAS_BITS) - 1);
+	if(!value) {
+		return PIXEL_OFF;
+	}
+	return (VM_CANVAS_BITS == 1) ? _ink : value - 1;
+}
+
+/*******************************************************************************
+Description: Sets every pixel of a rectangle.
+
+Parameters: -int x, int y - Top left pixel of the rectangle.
+			-int width, int height - Size of the rectangle in pixels.
+			-int color - Use constants RED, GREEN, AMBER, and PIXEL_OFF.
 
 Returns: 	-None
 
 Example Code:
+	levels.fillRect(0, 0, 100, 8, GREEN);
 *******************************************************************************/
-void VMDisplay::connect() {
-	VMClient.stop();	//disconnect modbus server
-	if (!VMClient.begin(address)) {	//begin modbus server on this display's IP
-		Serial.print("Modbus TCP Client on display with ID ");
-		Serial.print(_ID);
-		Serial.println(" failed!");
-		delay(500);
-		VMDisplay::connect();	//try and reconnect
+void VMCanvas::fillRect(int x, int y, int width, int height, int color) {
+	for(int row = y; row < y + height; row++) {
+		for(int column = x; column < x + width; column++) {
+			VMCanvas::setPixel(column, row, color);
+		}
 	}
 }
 
 /*******************************************************************************
-Description: Sends the data in the _commandData uint16_t array to the display
-			 using the modbus TCP server. It does this in one or more transactions
-			 of, at most, 246 bytes.
+Description: Draws the one pixel outline of a rectangle.
 
-Parameters: -None
+Parameters: -int x, int y - Top left pixel of the rectangle.
+			-int width, int height - Size of the rectangle in pixels.
+			-int color - Use constants RED, GREEN, AMBER, and PIXEL_OFF.
 
 Returns: 	-None
 
 Example Code:
+	levels.drawRect(0, 0, 102, 10, AMBER);
 *******************************************************************************/
-void VMDisplay::sendMessage() {
-	int commandPos = 0;	//counter for _commandData's position
-	int messagesToWrite = 0;	//amount of transmissions to perform
-	VMDisplay::connect();	//ensure connection to the correct modbus server
-	for(int i = 0; i < 6; i++) {	//determine how many messages to write
-		if(messageLength > 123 * i) {
-			messagesToWrite++;
-		}
-	}
-	if (!_completed) {	//make sure the current message hasn't already been written
-		for(int i = 0; i < messagesToWrite; i++) {	//make a transmission of 123 uint16_ts for every message to write
-			VMClient.beginTransmission(HOLDING_REGISTERS, 10999 + commandPos, 123);
-			for (int j = 0; j < 124; j++) {
-				if(!VMClient.write(_commandData[commandPos]) && i != 0) {
-					/*
-					Serial.print("Write of char failed: |");
-					Serial.print(_commandData[commandPos]);
-					Serial.print("| ");
-					Serial.print("At position: ");
-					Serial.println(i);
-					*/
-				}
-				else {
-					commandPos++;
-				}
+void VMCanvas::drawRect(int x, int y, int width, int height, int color) {
+	VMCanvas::fillRect(x, y, width, 1, color);
+	VMCanvas::fillRect(x, y + height - 1, width, 1, color);
+	VMCanvas::fillRect(x, y, 1, height, color);
+	VMCanvas::fillRect(x + width - 1, y, 1, height, color);
+}
+
+/*******************************************************************************
+Description: Draws a 1 bit per pixel icon. Rows start on a new byte and the
+			 leftmost pixel is the highest bit. Only the icon's lit pixels are
+			 drawn, the rest of the canvas is left as it was.
+
+Parameters: -int x, int y - Top left pixel of the icon.
+			-const uint8_t *bitmap - The icon's rows.
+			-int width, int height - Size of the icon in pixels.
+			-int color - Use constants RED, GREEN, AMBER, and PIXEL_OFF.
+
+Returns: 	-None
+
+Example Code:
+	const uint8_t drop[] = { 0x10, 0x38, 0x7C, 0x7C, 0x38 };
+	levels.drawBitmap(0, 0, drop, 7, 5, AMBER);
+*******************************************************************************/
+void VMCanvas::drawBitmap(int x, int y, const uint8_t *bitmap, int width, int height, int color) {
+	int stride = (width + 7) / 8;
+	for(int row = 0; row < height; row++) {
+		for(int column = 0; column < width; column++) {
+			if(bitmap[row * stride + column / 8] & (0x80 >> (column % 8))) {
+				VMCanvas::setPixel(x + column, y + row, color);
 			}
-			VMClient.endTransmission();
 		}
-		_completed = true;	//mark this message as being written
 	}
 }
+
+/*******************************************************************************
+Description: Checks if any pixel has changed since the canvas was last written
+			 into a message.
+
+Parameters: -None
+
+Returns: 	-true if the canvas has changed, false otherwise.
+
+Example Code:
+	if(levels.isDirty()) {...}
+*******************************************************************************/
+bool VMCanvas::isDirty() {
+	return _dirtyX1 <= _dirtyX2;
+}
+
+/*******************************************************************************
+Description: Gives the smallest rectangle holding every pixel changed since the
+			 canvas was last written into a message.
+
+Parameters: -int *x1, int *y1 - Top left pixel of the changes.
+			-int *x2, int *y2 - Bottom right pixel of the changes.
+
+Returns: 	-true if the canvas has changed, false otherwise.
+
+Example Code:
+	int x1, y1, x2, y2;
+	levels.dirtyRegion(&x1, &y1, &x2, &y2);
+*******************************************************************************/
+bool VMCanvas::dirtyRegion(int *x1, int *y1, int *x2, int *y2) {
+	*x1 = _dirtyX1;
+	*y1 = _dirtyY1;
+	*x2 = _dirtyX2;
+	*y2 = _dirtyY2;
+	return VMCanvas::isDirty();
+}
+
+/*******************************************************************************
+Description: Empties the dirty region. VMDisplay's canvas function does this once
+			 the canvas has been written into a message.
+
+Parameters: -None
+
+Returns: 	-None
+
+Example Code:
+	levels.markClean();
+*******************************************************************************/
+void VMCanvas::markClean() {
+	_dirtyX1 = 0;
+	_dirtyY1 = 0;
+	_dirtyX2 = -1;
+	_dirtyY2 = -1;
+}
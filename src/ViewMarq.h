@@ -50,24 +50,228 @@ SOFTWARE.
 
 #define NONE 3
 
+#define LINE_DEFAULT -1
+
+#ifndef VM_MAX_RUNS
+#define VM_MAX_RUNS 4	//differently formatted parts a line can hold
+#endif
+
+#ifndef VM_MAX_COMMAND
+#define VM_MAX_COMMAND 512	//size of the command string, including its terminating null
+#endif
+
+#ifndef VM_QUEUE_DEPTH
+#define VM_QUEUE_DEPTH 2	//variable writes that can wait for poll in queued mode (1-127)
+#endif
+
+#ifndef VM_ALARM_BUFFER
+#define VM_ALARM_BUFFER 0	//1 adds a message buffer holding the other alarm variant, so alarms switch without packing
+#endif
+
+#define VM_MESSAGE_BUFFERS (VM_ALARM_BUFFER ? 3 : 2)	//front and back, plus the alarm variant if enabled
+
+#ifndef VM_MAX_DISPLAYS
+#define VM_MAX_DISPLAYS 32	//displays startDisplays can bring up
+#endif
+
+#ifndef VM_PROBE_INTERVAL
+#define VM_PROBE_INTERVAL 5000	//milliseconds between maintain's checks of an open session
+#endif
+
+#ifndef VM_SHADOW_STRINGS
+#define VM_SHADOW_STRINGS 4	//string variables, from 1, whose last value is remembered (at most 16)
+#endif
+
+#ifndef VM_MAX_WIDGETS
+#define VM_MAX_WIDGETS 4	//bars, thresholds, and alarms a message can hold (at most 32)
+#endif
+
+#define VERIFY_OK 0
+#define VERIFY_RESENT 1
+#define VERIFY_UNAVAILABLE 2
+
+#define CAPTURE_SUCCEEDED 1	//set in a captured transaction's status if it succeeded
+#define CAPTURE_READ 2	//set in a captured transaction's status if registers were read
+
+#define VM_MAX_REGISTERS ((VM_MAX_COMMAND / 2) + 2)	//two chars per register plus end carriage chars
+
+#ifndef VM_CANVAS_WIDTH
+#define VM_CANVAS_WIDTH 288
+#endif
+
+#ifndef VM_CANVAS_HEIGHT
+#define VM_CANVAS_HEIGHT 32
+#endif
+
+#ifndef VM_CANVAS_BITS
+#define VM_CANVAS_BITS 2	//2 gives each pixel its own color, 1 halves the memory with one color for the canvas
+#endif
+
+#define VM_CANVAS_STRIDE ((VM_CANVAS_WIDTH * VM_CANVAS_BITS + 7) / 8)	//bytes per row of pixels
+
+#define PIXEL_OFF -1
+
+struct VMFormat {	//how formatStringVar shows a number
+	uint8_t width = 0;	//least characters before the suffix, padded on the left
+	uint8_t decimals = 0;	//digits after the decimal point, up to 9
+	char separator = 0;	//thousands separator, 0 for none
+	char pad = ' ';	//padding character, '0' pads between the sign and the number
+	bool showSign = false;	//show '+' in front of positive numbers
+	const char *suffix = NULL;	//UTF-8 unit after the number, NULL for none
+};
+
+class VMCanvas {
+	private:
+		uint8_t _pixels[VM_CANVAS_HEIGHT * VM_CANVAS_STRIDE];	//0 for off, otherwise the color + 1
+		int _ink = GREEN;
+		int _dirtyX1 = 0;	//dirty region, empty when _dirtyX1 > _dirtyX2
+		int _dirtyY1 = 0;
+		int _dirtyX2 = -1;
+		int _dirtyY2 = -1;
+	public:
+		VMCanvas() {
+			memset(_pixels, 0, sizeof(_pixels));
+		}
+		void clear();
+		void setInk(int color);
+		void setPixel(int x, int y, int color);
+		int getPixel(int x, int y);
+		void fillRect(int x, int y, int width, int height, int color);
+		void drawRect(int x, int y, int width, int height, int color);
+		void drawBitmap(int x, int y, const uint8_t *bitmap, int width, int height, int color);
+		bool isDirty();
+		bool dirtyRegion(int *x1, int *y1, int *x2, int *y2);
+		void markClean();
+};
+
 class VMDisplay {
 	private:
 		int _ID;
 		IPAddress address;
-		static Client *client;
-		bool _completed = false;
 		int _maintenanceCommand = 4;
-		uint16_t _commandData[512];
-		char _commandString[512];
-		char *_decLoc;
-		char *_strLoc;
+		uint16_t _commandData[VM_MESSAGE_BUFFERS][VM_MAX_REGISTERS];	//front, back, and alternate alarm message buffers
+		int _length[VM_MESSAGE_BUFFERS] = { 0 };
+		volatile uint8_t _front = 0;	//buffer sendMessage sends, the other one is written
+		volatile int8_t _sending = -1;	//buffer being sent, -1 if none
+		volatile uint16_t _published = 0;	//count of messages published
+		uint16_t _sent = 0;	//value of _published when the last send started
+		char _commandString[VM_MAX_COMMAND];
+		int _width = 288;
+		int _height = 32;
+		int _buildPos = 0;
+		int8_t _staging = -1;	//buffer the message being built is written in, -1 if none
+		bool _overflow = false;
+		bool _minimize = false;
+		bool _compress = false;
+		bool append(const char text[]);
+		bool append(char c);
+		bool appendNumber(long int number);
+		void charSet(int charSet);
+		int charSetOf(int textSize);
+		void packMessage();
+		void publishPacked(int back, int length);
+		int lineConfig(int lineSelected);
+		void finishMessage();
+		void appendText(const char text[], int length);
+		int runColor(int lineSelected, int run);
+		int backBuffer();
+		void publishMessage(int back, int length);
+		bool writeRegisters(int address, const uint16_t *data, int count);
+		void writeVariable(int address, const uint16_t *data, int count);
+		void rememberRegisters(int address, const uint16_t *data, int count);
+		struct QueuedWrite {
+			uint16_t address;
+			uint8_t count;
+			uint16_t data[50];
+		};
+		QueuedWrite _queue[VM_QUEUE_DEPTH];
+		volatile uint8_t _queueHead = 0;	//next entry to fill, written only by the producing task, counts to twice the depth
+		volatile uint8_t _queueTail = 0;	//next entry to send, written only by poll, counts to twice the depth
+		bool _queued = false;
+		bool _newSession = false;
+		unsigned long _probed = 0;	//millis when maintain last checked the display
+		Client *_client;	//communication client, which other displays may share
+		bool _session = false;	//this display opened the client's connection
+		static VMDisplay *_displays[VM_MAX_DISPLAYS];
+		static int _displayCount;
+		unsigned long _startupTime = 0;
+		bool _started = false;
+		int claimFront();
+		uint16_t _decValue[64];	//last registers written to each decimal variable
+		uint32_t _decWritten = 0;	//bit set for each decimal variable written
+		uint16_t _strValue[VM_SHADOW_STRINGS][50];	//last registers written to each remembered string variable
+		uint16_t _strWritten = 0;	//bit set for each remembered string variable written
+		uint16_t _scratch[50];	//registers a string variable is packed into before it is written
+		char *findField(const char name[], int variable);
+		bool setArgument(char *field, int argument, long int value);
+		int rewriteMessage(const char text[], char *arr, int size, bool minimize, bool compress);
+		int chunksFor(int length);
+		char _fillGlyph = 0x7F;
+		uint8_t _fillCharSet = 0;
+		uint8_t _fillWidth = 6;
+		uint8_t _fillHeight = 8;
+		struct Widget {
+			uint8_t type;	//bar or threshold
+			uint8_t variable;	//decimal variable the widget follows
+			uint8_t field;	//string variable a bar fills, or variable field a threshold colors
+			uint8_t size;	//cells of a bar, or 1 if a threshold colors a string variable
+			int8_t colors[2];	//colors below and above a threshold, or normal and alarmed
+			int8_t blinks[2];	//normal and alarmed blink
+			int16_t state;	//lit cells, current color, or alarm on, -1 until written
+			long int minimum;	//value of an empty bar, or a threshold's or alarm's limit
+			long int maximum;	//value of a full bar, or an alarm's clear level
+		};
+		Widget _widgets[VM_MAX_WIDGETS];
+		int _widgetCount = 0;
+		Widget _buildWidgets[VM_MAX_WIDGETS];	//widgets of the message being built
+		int _buildWidgetCount = 0;
+		int _pendingWidget = -1;	//threshold waiting for the field it colors
+		void writeDecimal(int variable, long int number, bool editBounds);
+		void updateWidgets(int variable, double value);
+		void bindWidget(int variable, bool string);
+		uint16_t *stringRegisters();
+		void writeStringVar(int variable, const uint16_t *registers, int chars, bool editBounds);
+		uint32_t _alarmed = 0;	//bit set for each alarm that is on
+		uint32_t _frontAlarmed = 0;	//alarms in the front buffer
+		int8_t _alternate = -1;	//buffer holding the other alarm variant, -1 if none
+		uint32_t _alternateAlarmed = 0;	//alarms in the alternate buffer
+		void checkAlarms(int variable, double value);
+		Print *_capture = NULL;	//where transactions are recorded, NULL if they aren't
+		void captureRecord(unsigned long time, int address, const uint16_t *data, int count, uint8_t status);
+		void captureRegister(uint16_t value);
+		long int readRegister(int address);
+		void switchAlarms(uint32_t alarmed);
+		uint32_t alarmMask();
+		int packVariant(int buffer, uint32_t alarmed);
+		bool packChars(uint16_t *data, int *count, const char text[], int length);
+		void alarmTags(char *tags, int blink, int color);
 	public:
-		static ModbusTCPClient VMClient;
-		VMDisplay(int ID, Client &tempClient, IPAddress &ip) : address(ip) {
+		ModbusTCPClient VMClient;
+		VMDisplay(int ID, Client &tempClient, IPAddress &ip) : address(ip), _client(&tempClient), VMClient(tempClient) {
 			VMDisplay::setLine(1, true);
-			client = &tempClient;
 			_ID = ID;
+			if(_displayCount < VM_MAX_DISPLAYS) {	//register for startDisplays
+				_displays[_displayCount] = this;
+				_displayCount++;
+			}
+		}
+		~VMDisplay() {
+			for(int i = 0; i < _displayCount; i++) {	//unregister so startDisplays never uses a destroyed display
+				if(_displays[i] == this) {
+					for(int j = i + 1; j < _displayCount; j++) {
+						_displays[j - 1] = _displays[j];
+					}
+					_displayCount--;
+					break;
+				}
+			}
 		}
+		struct Run {	//part of a line's text with its own settings, LINE_DEFAULT uses the line's
+			uint8_t start;
+			int8_t color;
+			int8_t textSize;
+			int8_t blink;
+		};
 		struct Line {
 			bool isEnabled = false;
 			int number;
@@ -78,6 +282,8 @@ class VMDisplay {
 			int blink = 3;
 			int variablePresent = 0;
 			char text[256];
+			Run runs[VM_MAX_RUNS];
+			int runCount = 0;
 		};
 		Line line[4];
 		void setLine(int lineSelected, bool state);
@@ -87,24 +293,63 @@ class VMDisplay {
 		void setScrollSpeed(int lineSelected, int scrollSpeed);
 		void setBlink(int lineSelected, int blink);
 		void setText(int lineSelected, const char text[]);
+		void addText(int lineSelected, const char text[], int color, int textSize = LINE_DEFAULT, int blink = LINE_DEFAULT);
 		void setTestCondition(int condition);
 
 		void updateDecimal(int variable, long int number, bool editBounds = true);
 		void updateDecimal(int variable, const double actual, bool editBounds = true);
 
 		void updateStringVar(int variable, const char text[100], bool editBounds = true);
+		void formatStringVar(int variable, long int number, const VMFormat &format, bool editBounds = true);
+		void formatStringVar(int variable, double number, const VMFormat &format, bool editBounds = true);
     
+		void setDisplaySize(int width, int height);
+		void beginMessage();
+		void win(int x1, int y1, int x2, int y2);
+		void pos(int x, int y);
+		void scroll(int scrollType, int scrollSpeed = MEDIUM);
+		void blink(int blink);
+		void font(int textSize);
+		void color(int color);
+		void text(const char text[]);
+		void dec(int variable, int digits, int places);
+		void str(int variable, int chars);
+		void bar(int variable, int stringVariable, int cells, long int minimum, long int maximum);
+		void threshold(int variable, long int limit, int below, int above);
+		void alarm(int variable, long int limit, long int clear, int color = GREEN, int alarmColor = RED, int alarmBlink = FAST);
+		void canvas(VMCanvas &canvas);
+		void setFillGlyph(char glyph, int charSet, int width, int height);
+		bool endMessage();
+		bool overflowed();
+
 		int lineConfig(int startPos, int lineSelected, char *arr);
 		int writeToArr(int startPos, const char text[], char *arr);
 		int generateString(char *string);
 		void writeMessage();
 		void writeMessage(const char text[]);
+		bool validateMessage(const char text[]);
+		int minimizeMessage(const char text[], char *arr, int size);
+		int compressMessage(const char text[], char *arr, int size, int *chunksBefore, int *chunksAfter);
+		int messageChunks();
+		void setMinimize(bool state, bool compress = false);
 		void resetMessage();
 		void printMessage();
 		void returnMessage(char *arr);
 		void changeIPAddress(IPAddress &ip);
 		void connect();
-		void sendMessage();
+		bool tryConnect();
+		static int startDisplays(unsigned long timeout);
+		unsigned long startupTime();
+		static void printStartupReport();
+		bool sendMessage();
+		void setQueued(bool state);
+		void setCapture(Print *sink);
+		long int replayCapture(Stream &log, float speed = 1);
+		void poll();
+		int verifyMessage(int samples = 4);
+		int verifyVariables();
+		bool maintain();
+		void replayState();
 
 		int messageLength = 0;
 };